@@ -24,10 +24,12 @@
 #include <command.h>
 #include <cpu_func.h>
 #include <irq_func.h>
+#include <mmc.h>
 #include <linux/delay.h>
 
 __weak void reset_misc(void)
 {
+	mmc_flush_caches();
 }
 
 int do_reset(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
@@ -869,6 +869,7 @@ void set_wdog_reset(struct wdog_regs *wdog)
 
 void reset_misc(void)
 {
+	mmc_flush_caches();
 #ifndef CONFIG_SPL_BUILD
 #if defined(CONFIG_VIDEO_MXS) && !defined(CONFIG_DM_VIDEO)
 	lcdif_power_down();
@@ -21,6 +21,7 @@
 #include <dm/device-internal.h>
 #include <env.h>
 #include <imx_thermal.h>
+#include <mmc.h>
 #include <asm/setup.h>
 #include <linux/delay.h>
 #include <fsl_wdog.h>
@@ -478,6 +479,7 @@ int boot_mode_getprisec(void)
 
 void reset_misc(void)
 {
+	mmc_flush_caches();
 #ifndef CONFIG_SPL_BUILD
 #if defined(CONFIG_VIDEO_MXS) && !defined(CONFIG_DM_VIDEO)
 	lcdif_power_down();
@@ -19,6 +19,7 @@
 #include <asm/arch/sys_proto.h>		/* is_mx6*() */
 #include <linux/delay.h>
 #include <linux/mtd/rawnand.h>		/* struct mtd_info */
+#include <nand.h>			/* get_nand_dev_by_index() */
 #include <dm/uclass.h>				/* uclass_get_device() */
 #include "fs_board_common.h"		/* Own interface */
 #include "fs_mmc_common.h"
@@ -27,6 +28,9 @@
 #endif
 #include <fuse.h>			/* fuse_read() */
 #include <update.h>			/* enum update_action */
+#include <bootstage.h>			/* bootstage_mark_name() */
+#include <malloc.h>			/* calloc(), free() */
+#include <sort.h>			/* qsort() */
 
 #ifdef CONFIG_FS_BOARD_CFG
 #include "fs_image_common.h"		/* fs_image_*() */
@@ -329,6 +333,8 @@ void fs_board_init_common(const struct fs_board_info *board_info)
 	/* Initialize thermal sensor */
 	uclass_get_device(UCLASS_THERMAL, 0, NULL);
 #endif
+
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "fs_board_init");
 }
 
 #ifdef CONFIG_BOARD_LATE_INIT
@@ -393,6 +399,17 @@ void fs_board_late_init_common(const char *serial_name)
 #ifdef CONFIG_FS_SELFTEST
 	/* Save dram_result for bdinfo */
 	fs_test_ram(dram_result);
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "fs_test_ram");
+#endif
+
+#ifdef CONFIG_NAND_REFRESH
+	/* Do the block refreshs that were queued in the previous session */
+	{
+		int i;
+
+		for (i = 0; i < CONFIG_SYS_MAX_NAND_DEVICE; i++)
+			nand_refresh_run_queue(get_nand_dev_by_index(i));
+	}
 #endif
 
 	/* Set sercon variable if not already set */
@@ -688,6 +705,7 @@ void fs_board_late_init_common(const char *serial_name)
 	}
 	// ### END IGX BOOT FLOW ###
 
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "fs_board_late_init");
 }
 #endif /* CONFIG_BOARD_LATE_INIT */
 
@@ -711,6 +729,138 @@ char *get_dram_result(void)
 }
 #endif
 
+#ifdef CONFIG_BOOTSTAGE
+/* ------------- Boot timing ----------------------------------------------- */
+
+struct fs_boot_stage {
+	const char *name;
+	ulong time_us;			/* Mark or accumulated time */
+	ulong elapsed_us;		/* Time spent in this stage */
+	bool accum;
+	char buf[20];			/* Name of records without name */
+};
+
+/* Sort marks by time, accumulated records go to the end */
+static int fs_boot_cmp_time(const void *p1, const void *p2)
+{
+	const struct fs_boot_stage *s1 = p1, *s2 = p2;
+
+	if (s1->accum != s2->accum)
+		return s1->accum ? 1 : -1;
+	if (s1->time_us == s2->time_us)
+		return 0;
+
+	return (s1->time_us > s2->time_us) ? 1 : -1;
+}
+
+/* Sort stages by decreasing time spent */
+static int fs_boot_cmp_elapsed(const void *p1, const void *p2)
+{
+	const struct fs_boot_stage *s1 = p1, *s2 = p2;
+
+	if (s1->elapsed_us == s2->elapsed_us)
+		return 0;
+
+	return (s1->elapsed_us < s2->elapsed_us) ? 1 : -1;
+}
+
+/*
+ * Show the boot stages that took most of the time. The time of a stage is
+ * the time from the previous mark to the mark of the stage itself, so all
+ * F&S marks are set at the end of the respective stage.
+ */
+static int do_fsboot_timing(struct cmd_tbl *cmdtp, int flag, int argc,
+			    char * const argv[])
+{
+	struct fs_boot_stage *stages, *s;
+	unsigned int count, show, i;
+	ulong time_us, prev_us;
+	bool accum;
+	char buf[20];
+
+	show = 10;
+	if (argc > 1)
+		show = simple_strtoul(argv[1], NULL, 0);
+
+	count = 0;
+	while (bootstage_get_record(count, buf, sizeof(buf), &time_us, &accum))
+		count++;
+	if (!count) {
+		puts("No boot stages recorded\n");
+		return CMD_RET_FAILURE;
+	}
+
+	stages = calloc(count, sizeof(struct fs_boot_stage));
+	if (!stages) {
+		puts("Cannot allocate memory for boot stages\n");
+		return CMD_RET_FAILURE;
+	}
+	for (i = 0, s = stages; i < count; i++, s++) {
+		s->name = bootstage_get_record(i, s->buf, sizeof(s->buf),
+					       &s->time_us, &s->accum);
+	}
+
+	/* Compute the time spent in each stage */
+	qsort(stages, count, sizeof(struct fs_boot_stage), fs_boot_cmp_time);
+	prev_us = 0;
+	for (i = 0, s = stages; i < count; i++, s++) {
+		if (s->accum) {
+			s->elapsed_us = s->time_us;
+		} else {
+			s->elapsed_us = s->time_us - prev_us;
+			prev_us = s->time_us;
+		}
+	}
+	qsort(stages, count, sizeof(struct fs_boot_stage), fs_boot_cmp_elapsed);
+
+	if (show > count)
+		show = count;
+	printf("Slowest %u of %u boot stages (last mark at %lu us):\n",
+	       show, count, prev_us);
+	printf("%11s  %s\n", "Time (us)", "Stage");
+	for (i = 0, s = stages; i < show; i++, s++) {
+		printf("%11lu  %s%s\n", s->elapsed_us, s->name,
+		       s->accum ? " (accumulated)" : "");
+	}
+	free(stages);
+
+	return CMD_RET_SUCCESS;
+}
+
+/* Subcommands for "fsboot" */
+static struct cmd_tbl cmd_fsboot_sub[] = {
+	U_BOOT_CMD_MKENT(timing, 2, 1, do_fsboot_timing, "", ""),
+};
+
+static int do_fsboot(struct cmd_tbl *cmdtp, int flag, int argc,
+		     char * const argv[])
+{
+	struct cmd_tbl *cp;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	/* Drop argv[0] ("fsboot") */
+	argc--;
+	argv++;
+
+	cp = find_cmd_tbl(argv[0], cmd_fsboot_sub,
+			  ARRAY_SIZE(cmd_fsboot_sub));
+	if (!cp)
+		return CMD_RET_USAGE;
+	if (flag == CMD_FLAG_REPEAT && !cmd_is_repeatable(cp))
+		return CMD_RET_SUCCESS;
+
+	return cp->cmd(cmdtp, flag, argc, argv);
+}
+
+U_BOOT_CMD(fsboot, 3, 1, do_fsboot,
+	   "F&S boot information",
+	   "timing [<n>]\n"
+	   "    - Show the <n> boot stages that took most time (default 10)\n"
+);
+#endif /* CONFIG_BOOTSTAGE */
+
 #endif /* ! CONFIG_SPL_BUILD */
 
 /* ============= Functions also available in SPL =========================== */
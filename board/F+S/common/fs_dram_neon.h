@@ -0,0 +1,24 @@
+/*
+ * fs_dram_neon.h
+ *
+ * (C) Copyright 2026
+ * F&S Elektronik Systeme GmbH
+ *
+ * NEON kernels for the DRAM tests.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __FS_DRAM_NEON_H__
+#define __FS_DRAM_NEON_H__
+
+/* Fill buf with alternating 64-bit words even/odd */
+void fs_dram_fill(void *buf, size_t len, u64 even, u64 odd);
+
+/* Check buf for even/odd pattern; return offset of first error or len */
+size_t fs_dram_check(const void *buf, size_t len, u64 even, u64 odd);
+
+/* Compare bufa and bufb; return offset of first difference or len */
+size_t fs_dram_compare(const void *bufa, const void *bufb, size_t len);
+
+#endif /* !__FS_DRAM_NEON_H__ */
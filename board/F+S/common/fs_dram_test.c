@@ -10,6 +10,11 @@
 #include "fs_board_common.h"/* fs_board_*() */
 #include <asm/global_data.h>
 #include <asm/arch/sys_proto.h>
+#ifdef CONFIG_FS_DRAM_NEON
+#include <cpu_func.h>
+#include <linux/sizes.h>
+#include "fs_dram_neon.h"
+#endif
 /* =============== SDRAM Test ============================================== */
 
 #define SIZETESTVALUE 0xA5                /* Testvalue for size detection */
@@ -102,6 +107,72 @@ static u64 TestRamCheck(volatile u8 *pchRam, u64 dwlInvert,
     return 0;
 }
 
+#ifdef CONFIG_FS_DRAM_NEON
+#define BW_TEST_SIZE SZ_8M
+
+/* Convert bytes and timer ticks to MB/s */
+static ulong bw_mbs(u64 bytes, u64 ticks)
+{
+	if (!ticks)
+		return 0;
+
+	return bytes * (get_tbclk() / 1000) / ticks / 1000;
+}
+
+/*
+ * Fill a block of RAM with solid bits, checkerboard and a walking bit in
+ * each byte lane, then read it back. This checks the data lines and shows
+ * the write and read bandwidth, e.g. to validate the DDR timing settings.
+ * Return the bad address or 0 if all values are correct.
+ */
+static u64 TestRamBandwidth(struct ramInfo *rI)
+{
+	u8 *pchRam = (u8 *)rI->pRamBase;
+	size_t len = BW_TEST_SIZE;
+	u64 wr_ticks = 0, rd_ticks = 0, bytes = 0;
+	u64 even, odd, start;
+	ulong wr, rd;
+	size_t offs;
+	int i;
+
+	if ((u64)rI->pUbootBase - (u64)rI->pRamBase < len)
+		len = (u64)rI->pUbootBase - (u64)rI->pRamBase;
+
+	for (i = 0; i < 10; i++) {
+		if (i == 0) {
+			even = 0x0000000000000000LU;	/* Solid bits */
+			odd = 0xFFFFFFFFFFFFFFFFLU;
+		} else if (i == 1) {
+			even = 0x5555555555555555LU;	/* Checkerboard */
+			odd = 0xAAAAAAAAAAAAAAAALU;
+		} else {
+			even = 0x0101010101010101LU << (i - 2);	/* Walking bit */
+			odd = ~even;
+		}
+
+		/* Flush to make sure that the data is really in DRAM */
+		start = get_ticks();
+		fs_dram_fill(pchRam, len, even, odd);
+		flush_dcache_range((ulong)pchRam, (ulong)pchRam + len);
+		wr_ticks += get_ticks() - start;
+
+		start = get_ticks();
+		offs = fs_dram_check(pchRam, len, even, odd);
+		rd_ticks += get_ticks() - start;
+		if (offs < len)
+			return (u64)pchRam + offs;
+		bytes += len;
+	}
+
+	wr = bw_mbs(bytes, wr_ticks);
+	rd = bw_mbs(bytes, rd_ticks);
+	printf("DRAM:  write %lu.%02lu GB/s, read %lu.%02lu GB/s\n",
+	       wr / 1000, (wr % 1000) / 10, rd / 1000, (rd % 1000) / 10);
+
+	return 0;
+}
+#endif
+
 /******************************************************************************
 *** Function:   void TestRAM(void)                                          ***
 ***                                                                         ***
@@ -375,6 +446,12 @@ int fs_test_ram(char * szStrBuffer)
 		dwBadAddress = TestRamCheck(pchRam, 0xFFFFFFFFFFFFFFFFLU, pMemInfo);
 	}
 
+#ifdef CONFIG_FS_DRAM_NEON
+	/* Step 3: Check data lines and measure bandwidth */
+	if (!dwBadAddress)
+		dwBadAddress = TestRamBandwidth(&rI);
+#endif
+
 	/* Print test result */
 	if (dwBadAddress)
 	{
@@ -14,6 +14,7 @@
 #ifdef CONFIG_CMD_NET
 
 #include <common.h>			/* Types */
+#include <bootstage.h>			/* bootstage_mark_name() */
 #include <net.h>			/* eth_env_get_enetaddr_by_index() */
 #include <asm/io.h>			/* __raw_readl() */
 #if defined(CONFIG_ARCH_IMX8)
@@ -134,6 +135,7 @@ void fs_eth_set_ethaddr(int index)
 	} while (i);
 
 	eth_env_set_enetaddr_by_index("eth", index, enetaddr);
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "fs_eth_set_ethaddr");
 }
 
 #endif /* CONFIG_CMD_NET */
@@ -18,6 +18,8 @@
 #include <cli.h>			/* get_board_name() */
 #include <net.h>			/* eth_env_get_enetaddr_by_index() */
 #include <fdt_support.h>		/* do_fixup_by_path_u32(), ... */
+#include <malloc.h>			/* malloc(), free() */
+#include <time.h>			/* timer_get_us() */
 #include <asm/arch/sys_proto.h>		/* get_reset_cause() */
 #include "fs_fdt_common.h"		/* Own interface */
 #include "fs_board_common.h"		/* fs_board_get_nboot_args() */
@@ -26,18 +28,424 @@
 #include "fs_processor_info.h"	/* fs_get_processorInfo() */
 #endif
 
+/*
+ * Pending device tree edits. Every fdt_setprop(), fdt_delprop() or
+ * fdt_del_node() moves the whole remaining tree in memory. So between
+ * fs_fdt_begin() and fs_fdt_commit(), edits are only recorded and the tree is
+ * rebuilt in one pass at the end. As the tree does not change in between, all
+ * node offsets stay valid.
+ */
+#define FS_FDT_MAX_EDITS 64		/* Number of pending edits */
+#define FS_FDT_POOL_SIZE 2048		/* Space for names and values */
+
+#define FS_FDT_ALIGN(x) (((x) + FDT_TAGSIZE - 1) & ~(FDT_TAGSIZE - 1))
+
+enum fs_fdt_edit_type {
+	FS_FDT_SETPROP,
+	FS_FDT_DELPROP,
+	FS_FDT_DELNODE,
+};
+
+struct fs_fdt_edit {
+	enum fs_fdt_edit_type type;
+	int offs;			/* Node offset in unmodified tree */
+	const char *name;		/* Property name (in pool) */
+	const void *val;		/* Property value (in pool) */
+	int len;			/* Length of value */
+	int nameoff;			/* Offset of name in strings */
+	int newname;			/* Name must be added to strings */
+	int applied;			/* Edit is in rebuilt tree */
+	int dropped;			/* Edit is obsolete */
+};
+
+static struct fs_fdt_edit fs_fdt_edits[FS_FDT_MAX_EDITS];
+static char fs_fdt_pool[FS_FDT_POOL_SIZE];
+static int fs_fdt_count;		/* Number of pending edits */
+static int fs_fdt_pool_used;		/* Used bytes in fs_fdt_pool */
+static void *fs_fdt_blob;		/* Device tree with pending edits */
+static unsigned long fs_fdt_start;	/* Time of fs_fdt_begin() in us */
+
+/* Find pending edit for node/property; name NULL: find node deletion */
+static struct fs_fdt_edit *fs_fdt_find_edit(int offs, const char *name)
+{
+	struct fs_fdt_edit *e;
+	int i;
+
+	for (i = 0, e = fs_fdt_edits; i < fs_fdt_count; i++, e++) {
+		if ((e->offs != offs) || e->applied || e->dropped)
+			continue;
+		if (!name) {
+			if (e->type == FS_FDT_DELNODE)
+				return e;
+		} else if ((e->type != FS_FDT_DELNODE)
+			   && !strcmp(e->name, name)) {
+			return e;
+		}
+	}
+
+	return NULL;
+}
+
+/* Copy data to the pool */
+static void *fs_fdt_pool_add(const void *data, int len)
+{
+	void *p;
+
+	if (fs_fdt_pool_used + len > FS_FDT_POOL_SIZE)
+		return NULL;
+	p = fs_fdt_pool + fs_fdt_pool_used;
+	memcpy(p, data, len);
+	fs_fdt_pool_used += len;
+
+	return p;
+}
+
+/* Record an edit; return 0 if recorded, 1 if it needs to be applied now */
+static int fs_fdt_record(void *fdt, enum fs_fdt_edit_type type, int offs,
+			 const char *name, const void *val, int len)
+{
+	struct fs_fdt_edit *e;
+	const char *pname = NULL;
+	const void *pval = NULL;
+
+	if ((fdt != fs_fdt_blob) || (offs < 0)
+	    || !fdt_get_name(fdt, offs, NULL))
+		return 1;
+
+	/* A second edit of the same property replaces the first one */
+	e = fs_fdt_find_edit(offs, name);
+	if (e) {
+		pname = e->name;
+	} else {
+		if (fs_fdt_count >= FS_FDT_MAX_EDITS)
+			return 1;
+		if (name) {
+			pname = fs_fdt_pool_add(name, strlen(name) + 1);
+			if (!pname)
+				return 1;
+		}
+	}
+	if (len) {
+		pval = fs_fdt_pool_add(val, len);
+		if (!pval) {
+			/* Will be applied directly, so drop older edit */
+			if (e)
+				e->dropped = 1;
+			return 1;
+		}
+	}
+	if (!e)
+		e = &fs_fdt_edits[fs_fdt_count++];
+	e->type = type;
+	e->offs = offs;
+	e->name = pname;
+	e->val = pval;
+	e->len = len;
+	e->applied = 0;
+	e->dropped = 0;
+
+	return 0;
+}
+
+/*
+ * The tree was modified directly at pos while edits are pending, with size of
+ * structure block being size before. Move the offsets of all pending edits
+ * behind pos accordingly.
+ */
+static void fs_fdt_shift(void *fdt, int pos, int size)
+{
+	int delta = fdt_size_dt_struct(fdt) - size;
+	struct fs_fdt_edit *e;
+	int i;
+
+	if ((fdt != fs_fdt_blob) || !delta)
+		return;
+
+	for (i = 0, e = fs_fdt_edits; i < fs_fdt_count; i++, e++) {
+		if (e->offs < pos)
+			continue;
+		if ((delta < 0) && (e->offs < pos - delta))
+			e->dropped = 1;		/* Node was removed */
+		else
+			e->offs += delta;
+	}
+}
+
+/* Find string in strings block, return offset or -1 if not found */
+static int fs_fdt_find_string(const void *fdt, const char *str)
+{
+	const char *strtab = (const char *)fdt + fdt_off_dt_strings(fdt);
+	int size = fdt_size_dt_strings(fdt);
+	int len = strlen(str) + 1;
+	const char *p;
+
+	for (p = strtab; p + len <= strtab + size; p += strlen(p) + 1) {
+		if (!memcmp(p, str, len))
+			return p - strtab;
+	}
+
+	return -1;
+}
+
+/* Write a property to the structure block */
+static char *fs_fdt_put_prop(char *p, fdt32_t nameoff, const void *val,
+			     int len)
+{
+	struct fdt_property *prop = (struct fdt_property *)p;
+
+	prop->tag = cpu_to_fdt32(FDT_PROP);
+	prop->len = cpu_to_fdt32(len);
+	prop->nameoff = nameoff;
+	if (len)
+		memcpy(prop->data, val, len);
+	memset(prop->data + len, 0, FS_FDT_ALIGN(len) - len);
+
+	return p + sizeof(*prop) + FS_FDT_ALIGN(len);
+}
+
+/* Write all new properties of a node to the structure block */
+static char *fs_fdt_put_new_props(char *p, int offs)
+{
+	struct fs_fdt_edit *e;
+	int i;
+
+	for (i = 0, e = fs_fdt_edits; i < fs_fdt_count; i++, e++) {
+		if ((e->offs != offs) || e->applied || e->dropped
+		    || (e->type != FS_FDT_SETPROP))
+			continue;
+		p = fs_fdt_put_prop(p, cpu_to_fdt32(e->nameoff), e->val,
+				    e->len);
+		e->applied = 1;
+	}
+
+	return p;
+}
+
+/* Rebuild the device tree with all pending edits in one pass */
+static int fs_fdt_rebuild(void *fdt)
+{
+	int off_struct = fdt_off_dt_struct(fdt);
+	int size_struct = fdt_size_dt_struct(fdt);
+	int size_strings = fdt_size_dt_strings(fdt);
+	const struct fdt_property *prop;
+	struct fs_fdt_edit *e;
+	int offset, next, cur, skip, len, i;
+	char *buf, *p;
+	uint32_t tag;
+
+	if ((fdt_version(fdt) < 17) || (fdt_off_mem_rsvmap(fdt) > off_struct)
+	    || (fdt_off_dt_strings(fdt) < off_struct + size_struct))
+		return -FDT_ERR_BADLAYOUT;
+
+	/* Get offsets of property names and maximum size of new tree */
+	for (i = 0, e = fs_fdt_edits; i < fs_fdt_count; i++, e++) {
+		e->newname = 0;
+		if (e->dropped || (e->type != FS_FDT_SETPROP))
+			continue;
+		if (fdt_getprop(fdt, e->offs, e->name, &len))
+			size_struct += FS_FDT_ALIGN(e->len) - FS_FDT_ALIGN(len);
+		else
+			size_struct += sizeof(*prop) + FS_FDT_ALIGN(e->len);
+		e->nameoff = fs_fdt_find_string(fdt, e->name);
+		if (e->nameoff < 0) {
+			e->nameoff = size_strings;
+			e->newname = 1;
+			size_strings += strlen(e->name) + 1;
+		}
+	}
+	if (off_struct + size_struct + size_strings > fdt_totalsize(fdt))
+		return -FDT_ERR_NOSPACE;
+
+	buf = malloc(fdt_totalsize(fdt));
+	if (!buf)
+		return -FDT_ERR_NOSPACE;
+
+	/* Header and memory reservation block are unchanged */
+	memcpy(buf, fdt, off_struct);
+
+	/* Copy structure block and apply edits on the way */
+	p = buf + off_struct;
+	cur = -1;
+	skip = 0;
+	offset = 0;
+	do {
+		tag = fdt_next_tag(fdt, offset, &next);
+		if (next < 0) {
+			free(buf);
+			return next;
+		}
+		if (skip) {
+			/* Inside of a deleted node */
+			if (tag == FDT_BEGIN_NODE)
+				skip++;
+			else if (tag == FDT_END_NODE)
+				skip--;
+			offset = next;
+			continue;
+		}
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+		case FDT_END_NODE:
+			/* End of properties of current node, add new ones */
+			if (cur >= 0)
+				p = fs_fdt_put_new_props(p, cur);
+			cur = -1;
+			if (tag == FDT_BEGIN_NODE) {
+				e = fs_fdt_find_edit(offset, NULL);
+				if (e) {
+					e->applied = 1;
+					skip = 1;
+					break;
+				}
+				cur = offset;
+			}
+			memcpy(p, (char *)fdt + off_struct + offset,
+			       next - offset);
+			p += next - offset;
+			break;
+
+		case FDT_PROP:
+			prop = fdt_offset_ptr(fdt, offset, sizeof(*prop));
+			e = fs_fdt_find_edit(cur, fdt_string(fdt,
+						fdt32_to_cpu(prop->nameoff)));
+			if (e) {
+				if (e->type == FS_FDT_SETPROP)
+					p = fs_fdt_put_prop(p, prop->nameoff,
+							    e->val, e->len);
+				e->applied = 1;
+				break;
+			}
+			/* Fall through */
+		case FDT_END:
+			memcpy(p, (char *)fdt + off_struct + offset,
+			       next - offset);
+			p += next - offset;
+			break;
+
+		default:
+			/* Drop FDT_NOP */
+			break;
+		}
+		offset = next;
+	} while (tag != FDT_END);
+
+	/* Copy strings block and append new names */
+	size_struct = p - (buf + off_struct);
+	len = fdt_size_dt_strings(fdt);
+	memcpy(p, (char *)fdt + fdt_off_dt_strings(fdt), len);
+	for (i = 0, e = fs_fdt_edits; i < fs_fdt_count; i++, e++) {
+		if (e->newname) {
+			strcpy(p + e->nameoff, e->name);
+			len = e->nameoff + strlen(e->name) + 1;
+		}
+	}
+
+	fdt_set_size_dt_struct(buf, size_struct);
+	fdt_set_off_dt_strings(buf, off_struct + size_struct);
+	fdt_set_size_dt_strings(buf, len);
+	memcpy(fdt, buf, off_struct + size_struct + len);
+	free(buf);
+
+	return 0;
+}
+
+/* Apply edits one by one, from the end of the tree to the start */
+static void fs_fdt_apply_single(void *fdt)
+{
+	struct fs_fdt_edit *e, *last;
+	int i, err;
+
+	do {
+		last = NULL;
+		for (i = 0, e = fs_fdt_edits; i < fs_fdt_count; i++, e++) {
+			if (e->dropped)
+				continue;
+			/* Delete node after all other edits of this node */
+			if (!last || (e->offs > last->offs)
+			    || ((e->offs == last->offs)
+				&& (last->type == FS_FDT_DELNODE)))
+				last = e;
+		}
+		if (!last)
+			break;
+		last->dropped = 1;
+		if (last->type == FS_FDT_SETPROP)
+			err = fdt_setprop(fdt, last->offs, last->name,
+					  last->val, last->len);
+		else if (last->type == FS_FDT_DELPROP)
+			err = fdt_delprop(fdt, last->offs, last->name);
+		else
+			err = fdt_del_node(fdt, last->offs);
+		if (err && (last->type == FS_FDT_SETPROP)) {
+			printf("## Unable to update property %s/%s: err=%s\n",
+			       fdt_get_name(fdt, last->offs, NULL), last->name,
+			       fdt_strerror(err));
+		}
+	} while (1);
+}
+
+/* Start recording device tree edits */
+void fs_fdt_begin(void *fdt)
+{
+	fs_fdt_blob = fdt;
+	fs_fdt_count = 0;
+	fs_fdt_pool_used = 0;
+	fs_fdt_start = timer_get_us();
+}
+
+/* Apply all recorded device tree edits */
+int fs_fdt_commit(void *fdt)
+{
+	int err = 0;
+
+	if (fdt != fs_fdt_blob)
+		return 0;
+
+	if (fs_fdt_count) {
+		err = fs_fdt_rebuild(fdt);
+		if (err) {
+			printf("## Rebuilding device tree failed: err=%s\n",
+			       fdt_strerror(err));
+			fs_fdt_apply_single(fdt);
+		}
+	}
+	fs_fdt_blob = NULL;
+
+	printf("   Applied %d board fixups to device tree in %lu us\n",
+	       fs_fdt_count, timer_get_us() - fs_fdt_start);
+
+	return 0;
+}
+
+/* Get value of a property, taking pending edits into account */
+static const void *fs_fdt_getprop(void *fdt, int offs, const char *name,
+				  int *len)
+{
+	struct fs_fdt_edit *e = NULL;
+
+	if (fdt == fs_fdt_blob)
+		e = fs_fdt_find_edit(offs, name);
+	if (!e)
+		return fdt_getprop(fdt, offs, name, len);
+	if (e->type != FS_FDT_SETPROP)
+		return NULL;
+	*len = e->len;
+
+	return e->val ? e->val : "";
+}
+
 /* Set a generic value, if it was not already set in the device tree */
 void fs_fdt_set_val(void *fdt, int offs, const char *name, const void *val,
 		    int len, int force)
 {
-	int err;
+	int err, size;
 
 	/* Keep value if "no-uboot-override" is set */
 	if (fdt_get_property(fdt, offs, "no-uboot-override", NULL) != NULL)
 		force = 0;
 
 	/* Warn if property already exists in device tree */
-	if (fdt_get_property(fdt, offs, name, NULL) != NULL) {
+	if (fs_fdt_getprop(fdt, offs, name, &size) != NULL) {
 		printf("## %s property %s/%s from device tree!\n",
 		       force ? "Overwriting": "Keeping",
 		       fdt_get_name(fdt, offs, NULL), name);
@@ -45,7 +453,12 @@ void fs_fdt_set_val(void *fdt, int offs, const char *name, const void *val,
 			return;
 	}
 
+	if (!fs_fdt_record(fdt, FS_FDT_SETPROP, offs, name, val, len))
+		return;
+
+	size = fdt_size_dt_struct(fdt);
 	err = fdt_setprop(fdt, offs, name, val, len);
+	fs_fdt_shift(fdt, offs + 1, size);
 	if (err) {
 		printf("## Unable to update property %s/%s: err=%s\n",
 		       fdt_get_name(fdt, offs, NULL), name, fdt_strerror(err));
@@ -145,12 +558,18 @@ int fs_fdt_enable(void *fdt, const char *path, int enable)
 		return offs;
 
 	/* Do not change if status already exists and has this value */
-	val = fdt_getprop(fdt, offs, "status", &len);
+	val = fs_fdt_getprop(fdt, offs, "status", &len);
 	if (val && len && !strcmp(val, str))
 		return -1;
 
 	/* No, set new value */
+	if (!fs_fdt_record(fdt, FS_FDT_SETPROP, offs, "status", str,
+			   strlen(str) + 1))
+		return 0;
+
+	len = fdt_size_dt_struct(fdt);
 	err = fdt_setprop_string(fdt, offs, "status", str);
+	fs_fdt_shift(fdt, offs + 1, len);
 	if (err) {
 		printf("## Can not set status of node %s: err=%s\n",
 		       path, fdt_strerror(err));
@@ -160,6 +579,36 @@ int fs_fdt_enable(void *fdt, const char *path, int enable)
 	return  0;
 }
 
+/* Delete a property */
+int fs_fdt_delprop(void *fdt, int offs, const char *name)
+{
+	int err, size;
+
+	if (!fs_fdt_record(fdt, FS_FDT_DELPROP, offs, name, NULL, 0))
+		return 0;
+
+	size = fdt_size_dt_struct(fdt);
+	err = fdt_delprop(fdt, offs, name);
+	fs_fdt_shift(fdt, offs + 1, size);
+
+	return err;
+}
+
+/* Delete a node with all its subnodes */
+int fs_fdt_del_node(void *fdt, int offs)
+{
+	int err, size;
+
+	if (!fs_fdt_record(fdt, FS_FDT_DELNODE, offs, NULL, NULL, 0))
+		return 0;
+
+	size = fdt_size_dt_struct(fdt);
+	err = fdt_del_node(fdt, offs);
+	fs_fdt_shift(fdt, offs, size);
+
+	return err;
+}
+
 /* Store common board specific values in node bdinfo */
 void fs_fdt_set_bdinfo(void *fdt, int offs)
 {
@@ -170,8 +619,10 @@ void fs_fdt_set_bdinfo(void *fdt, int offs)
 #ifdef CONFIG_FUS_BOARDCFG_ADDR
 	void *fdt_cfg = fs_image_get_cfg_fdt();
 	int offs_cfg = fs_image_get_board_cfg_offs(fdt_cfg);
+	int size = fdt_size_dt_struct(fdt);
 	int offs_bdinfo_cfg = fdt_add_subnode(fdt, offs, "board-cfg");
 	fdt_overlay_apply_node(fdt, offs_bdinfo_cfg, fdt_cfg, offs_cfg);
+	fs_fdt_shift(fdt, offs_bdinfo_cfg, size);
 
 	fs_image_set_board_id_from_cfg();
 	fs_fdt_set_string(fdt, offs, "board-id", fs_image_get_board_id(), 1);
@@ -12,6 +12,12 @@
 #ifndef __FS_FDT_COMMON_H__
 #define __FS_FDT_COMMON_H__
 
+/* Start recording device tree edits */
+void fs_fdt_begin(void *fdt);
+
+/* Apply all recorded device tree edits */
+int fs_fdt_commit(void *fdt);
+
 /* Set a generic value, if it was not already set in the device tree */
 void fs_fdt_set_val(void *fdt, int offs, const char *name, const void *val,
 		    int len, int force);
@@ -42,6 +48,12 @@ int fs_fdt_path_offset(void *fdt, const char *path);
 /* Enable or disable node given by path, overwrite any existing status value */
 int fs_fdt_enable(void *fdt, const char *path, int enable);
 
+/* Delete a property */
+int fs_fdt_delprop(void *fdt, int offs, const char *name);
+
+/* Delete a node with all its subnodes */
+int fs_fdt_del_node(void *fdt, int offs);
+
 /* Store common board specific values in node bdinfo */
 void fs_fdt_set_bdinfo(void *fdt, int offs);
 
@@ -141,7 +141,9 @@
 
 #include <common.h>
 #include <fdt_support.h>		/* fdt_getprop_u32_default_node() */
+#include <hash.h>			/* hash_lookup_algo() */
 #include <spl.h>
+#include <memalign.h>			/* malloc_cache_aligned() */
 #include <mmc.h>
 #include <nand.h>
 #include <sdp.h>
@@ -767,6 +769,42 @@ bool fs_image_find_cfg_in_ocram(void)
 	return false;
 }
 
+#ifdef CONFIG_FS_IMAGE_SHA256
+/*
+ * Check SHA-256; return: 0: No SHA-256, 1: SHA-256 OK, <0: error (SHA-256
+ * failed). The digest is stored in the last 32 bytes of the image and covers
+ * all image data before it. It is computed by the generic hashing API, which
+ * uses the CAAM job ring if available (CONFIG_SHA_HW_ACCEL) and the software
+ * implementation otherwise.
+ */
+int fs_image_check_sha256(const struct fs_header_v1_0 *fsh)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, digest, FSH_SHA256_SIZE);
+	const u8 *image = (const u8 *)(fsh + 1);
+	struct hash_algo *algo;
+	unsigned int size;
+	int err;
+
+	if (!(fsh->info.flags & FSH_FLAGS_SHA256))
+		return 0;		/* No SHA-256 */
+
+	size = fs_image_get_size(fsh, false);
+	if (size < FSH_SHA256_SIZE)
+		return -EINVAL;
+	size -= FSH_SHA256_SIZE;
+
+	err = hash_lookup_algo("sha256", &algo);
+	if (err)
+		return err;
+
+	algo->hash_func_ws(image, size, digest, algo->chunk_size);
+	if (memcmp(digest, image + size, FSH_SHA256_SIZE))
+		return -EILSEQ;
+
+	return 1;
+}
+#endif /* CONFIG_FS_IMAGE_SHA256 */
+
 static int fs_image_fdt_err(const char *name, const char *reason, int err)
 {
 	printf("Entry %s in BOARD-CFG %s\n", name, reason);
@@ -958,6 +996,11 @@ static struct fs_header_v1_0 one_fsh;	/* Buffer for one F&S header */
 static void *validate_addr = NULL;
 static void *final_addr;
 static bool keep_fs_header;
+static unsigned int peek_remaining;	/* Image bytes after the IVT part */
+static bool stream;			/* Image is streamed to final_addr */
+static bool stream_crc_image;		/* CRC32 covers the streamed data */
+static u32 stream_crc;			/* CRC32 computed while streaming */
+static unsigned int stream_size;	/* Bytes written to final_addr */
 
 #define MAX_NEST_LEVEL 8
 
@@ -1054,6 +1097,20 @@ static void fs_image_enter(unsigned int size, enum fsimg_state new_state)
 	fs_image_next_header(new_state);
 }
 
+#ifdef CONFIG_FS_IMAGE_STREAM_VALIDATE
+/* Check if an unsigned image may be written to its final address unchecked */
+static bool fs_image_can_stream(void)
+{
+#ifdef CONFIG_IMX_HAB
+	/* A closed board only accepts signed images, authenticated first */
+	if (imx_hab_is_enabled())
+		return false;
+#endif
+
+	return true;
+}
+#endif
+
 /* State machine: Load data of given size to given address, go to new state */
 static void fs_image_copy(void *final, void *validate, unsigned int size,
 			  bool keep)
@@ -1062,6 +1119,9 @@ static void fs_image_copy(void *final, void *validate, unsigned int size,
 	count = size;
 	mode = FSIMG_MODE_IMAGE;
 	keep_fs_header = keep;
+	peek_remaining = 0;
+	stream = false;
+	stream_crc_image = false;
 
 #ifndef CONFIG_FS_SECURE_BOOT
 	/* No CRC32 active in image, copy directly to final address */
@@ -1071,6 +1131,7 @@ static void fs_image_copy(void *final, void *validate, unsigned int size,
 			final += FSH_SIZE;
 		}
 		validate_addr = NULL;
+		addr = final;
 		debug("Loading 0x%x bytes directly to 0x%08lx\n", size,
 		      (ulong)final);
 		return;
@@ -1088,10 +1149,105 @@ static void fs_image_copy(void *final, void *validate, unsigned int size,
 	memcpy(validate, &one_fsh, FSH_SIZE);
 	validate += FSH_SIZE;
 	addr = validate;
+
+#ifdef CONFIG_FS_IMAGE_STREAM_VALIDATE
+	/*
+	 * We can only tell if the image is signed when we see the IVT. So load
+	 * only this part to the validation address first. If the image turns
+	 * out to be unsigned, the rest can be streamed directly to the final
+	 * address, see fs_image_handle_peek().
+	 */
+	if ((size > HAB_HEADER) && fs_image_can_stream()) {
+		count = HAB_HEADER;
+		peek_remaining = size - HAB_HEADER;
+		debug("Loading 0x%x bytes to temp 0x%08lx to check for IVT\n",
+		      count, (ulong)addr);
+		return;
+	}
+#endif
+
 	debug("Loading 0x%x bytes to temp 0x%08lx for validation\n",
 	      size, (ulong)addr);
 }
 
+/*
+ * State machine: The part of the image where an IVT would be is loaded. If the
+ * image is signed, continue loading to the validation address, because HAB
+ * can only authenticate the image there. Otherwise move the data loaded so
+ * far to the final address, let the rest of the image be loaded directly
+ * behind it and compute the CRC32 on the fly while the data is coming in.
+ * This saves the final copy in fs_image_validate_spl().
+ */
+static void fs_image_handle_peek(void)
+{
+	struct fs_header_v1_0 *fsh = validate_addr;
+	struct fs_header_v1_0 crc_fsh;
+	void *dest = final_addr;
+
+	count = peek_remaining;
+	peek_remaining = 0;
+
+	if (fs_image_is_signed(fsh)) {
+		debug("Signed image, loading 0x%x bytes to temp 0x%08lx\n",
+		      count, (ulong)addr);
+		return;
+	}
+
+	/* Header and IVT part are consecutive at the validation address */
+	if (keep_fs_header) {
+		memmove(dest, fsh, FSH_SIZE + HAB_HEADER);
+		dest += FSH_SIZE;
+	} else {
+		memmove(dest, fsh + 1, HAB_HEADER);
+	}
+
+	/* CRC32 is in type[12..15] and was computed with this set to 0 */
+	stream_crc = 0;
+	if (one_fsh.info.flags & FSH_FLAGS_SECURE) {
+		crc_fsh = one_fsh;
+		*(u32 *)&crc_fsh.type[12] = 0;
+		stream_crc = crc32(stream_crc, (uchar *)&crc_fsh, FSH_SIZE);
+	}
+	stream_crc_image = !!(one_fsh.info.flags & FSH_FLAGS_CRC32);
+	if (stream_crc_image)
+		stream_crc = crc32(stream_crc, dest, HAB_HEADER);
+
+	stream_size = dest - final_addr + HAB_HEADER + count;
+	stream = true;
+	addr = dest + HAB_HEADER;
+	debug("Streaming 0x%x bytes to final 0x%08lx\n", count, (ulong)addr);
+}
+
+/* Account for image data that was just stored at addr while streaming */
+static void fs_image_stream_data(const void *buf, unsigned int len)
+{
+	if (stream && stream_crc_image)
+		stream_crc = crc32(stream_crc, buf, len);
+}
+
+/* Validate a streamed image; destroy it at the final address if invalid */
+static bool fs_image_validate_stream(const char *type, const char *descr)
+{
+	u32 expected_cs = *(u32 *)&one_fsh.type[12];
+
+	debug("unsigned, streamed");
+	if (!(one_fsh.info.flags & (FSH_FLAGS_SECURE | FSH_FLAGS_CRC32))) {
+		debug(", no CRC32 (OK)\n");
+		return true;
+	}
+
+	if (stream_crc != expected_cs) {
+		printf("\nError: CRC32 of %s (%s) FAILED!\n", type, descr);
+
+		/* Do not leave any part of the broken image in place */
+		memset(final_addr, 0, stream_size);
+		return false;
+	}
+
+	debug(", CRC32 OK\n");
+	return true;
+}
+
 /* State machine: Skip data of given size */
 static void fs_image_skip(unsigned int size)
 {
@@ -1153,6 +1309,10 @@ static bool fs_image_validate_spl(const char *type, const char *descr)
 
 	debug("Got %s (%s), ", type, descr);
 
+	/* Image that was validated while streaming to the final address */
+	if (stream)
+		return fs_image_validate_stream(type, descr);
+
 #ifndef CONFIG_FS_SECURE_BOOT
 	/* Image without CRC32 that was loaded directly to the final address */
 	if (!fsh) {
@@ -1473,7 +1633,10 @@ static void fs_image_handle(void)
 		break;
 
 	case FSIMG_MODE_IMAGE:
-		fs_image_handle_image();
+		if (peek_remaining)
+			fs_image_handle_peek();
+		else
+			fs_image_handle_image();
 		break;
 
 	case FSIMG_MODE_SKIP:
@@ -1508,6 +1671,8 @@ static void fs_image_sdp_rx_data(u8 *data_buf, int data_len)
 		chunk = min((unsigned int)data_len, count);
 		if ((mode == FSIMG_MODE_IMAGE) || (mode == FSIMG_MODE_HEADER))
 			memcpy(addr, data_buf, chunk);
+		if (mode == FSIMG_MODE_IMAGE)
+			fs_image_stream_data(addr, chunk);
 
 		addr += chunk;
 		data_buf += chunk;
@@ -1579,97 +1744,103 @@ static int fs_image_get_flash_info_spl_nand(struct flash_info_spl *fi)
 #endif /* CONFIG_NAND_MXS */
 
 #ifdef CONFIG_MMC
-/* Load MMC data from arbitrary offsets, not necessarily MMC block aligned */
-static int fs_image_gen_load_mmc(uint32_t offs, unsigned int size, void *buf)
+/*
+ * Prefetch window for MMC. Headers and the unaligned head and tail of images
+ * are taken from this buffer, so that walking through the F&S headers does
+ * not issue one small read for each header and no block is read twice.
+ */
+static struct mmc_window {
+	struct blk_desc *blk_desc;	/* Block device the window belongs to */
+	u8 *buf;			/* Buffer, allocated once */
+	lbaint_t start;			/* First MMC block in buffer */
+	lbaint_t count;			/* Number of valid MMC blocks in buffer */
+} mmc_window;
+
+/* Fill the prefetch window with blocks beginning at given block */
+static int fs_image_fill_window_mmc(lbaint_t blk)
 {
+	struct mmc_window *win = &mmc_window;
+	struct blk_desc *blk_desc = win->blk_desc;
+	lbaint_t blkcnt = CONFIG_FS_IMAGE_MMC_PREFETCH;
 	unsigned long n;
-	unsigned int chunk_offs;
-	unsigned int chunk_size;
-	static u8 *local_buffer;	/* Space for one MMC block */
-	struct mmc *mmc;
-	struct blk_desc *blk_desc;
-	unsigned long blksz;
-//###	int err;
-
-	mmc = find_mmc_device(0);
-#if 0 //### we can skip initialization, already done in fs_image_load_system()
-	if (!mmc) {
-		puts("MMC boot device not found\n");
-		return -ENODEV;
-	}
-	err = mmc_init(mmc);
-	if (err) {
-		printf("mmc_init() failed (%d)\n", err);
-		return err;
-	}
-#endif
-	blk_desc = mmc_get_blk_desc(mmc);
-	blksz = blk_desc->blksz;
 
-	/* We need a buffer for one MMC block; only allocate once */
-	if (!local_buffer) {
-		local_buffer = malloc(blksz);
-		if (!local_buffer) {
+	/* We need a buffer for the window; only allocate once */
+	if (!win->buf) {
+		win->buf = malloc_cache_aligned(blkcnt * blk_desc->blksz);
+		if (!win->buf) {
 			puts("Can not allocate local buffer for MMC\n");
 			return -ENOMEM;
 		}
 	}
 
-	chunk_offs = offs % blksz;
-	offs /= blksz;			/* From now on offs is in MMC blocks */
+	if (blk >= blk_desc->lba)
+		return -EIO;
+	if (blkcnt > blk_desc->lba - blk)
+		blkcnt = blk_desc->lba - blk;
 
-	/*
-	 * If not starting from an MMC block boundary, load one block to local
-	 * buffer and take some bytes from the end to get aligned.
-	 */
-	if (chunk_offs) {
-		chunk_size = blksz - chunk_offs;
-		if (chunk_size > size)
-			chunk_size = size;
-		n = blk_dread(blk_desc, offs, 1, local_buffer);
-		if (IS_ERR_VALUE(n))
-			return (int)n;
-		if (n < 1)
-			return -EIO;
-		memcpy(buf, local_buffer + chunk_offs, chunk_size);
-		offs++;
-		buf += chunk_size;
-		size -= chunk_size;
-	}
+	win->count = 0;
+	n = blk_dread(blk_desc, blk, blkcnt, win->buf);
+	if (IS_ERR_VALUE(n))
+		return (int)n;
+	if (n < blkcnt)
+		return -EIO;
+	win->start = blk;
+	win->count = blkcnt;
+
+	return 0;
+}
+
+/*
+ * Load MMC data from arbitrary offsets, not necessarily MMC block aligned.
+ * Data that is already in the prefetch window is copied from there, aligned
+ * runs of full blocks are read with one multi-block transfer directly to the
+ * target address. Only the unaligned head and tail go through the window.
+ */
+static int fs_image_gen_load_mmc(uint32_t offs, unsigned int size, void *buf)
+{
+	struct mmc_window *win = &mmc_window;
+	unsigned long blksz = win->blk_desc->blksz;
+	unsigned int chunk_offs;
+	unsigned int chunk_size;
+	lbaint_t blk;
+	unsigned long n;
+	int err;
+
+	while (size) {
+		blk = offs / blksz;
+		chunk_offs = offs % blksz;
+
+		if ((blk >= win->start) && (blk < win->start + win->count)) {
+			/* Take as much data as possible from the window */
+			chunk_size = (win->start + win->count - blk) * blksz
+				- chunk_offs;
+			if (chunk_size > size)
+				chunk_size = size;
+			memcpy(buf, win->buf + (blk - win->start) * blksz
+			       + chunk_offs, chunk_size);
+		} else if (!chunk_offs && (size >= blksz)
+			   && !((unsigned long)buf & 3)) {
+			/* Load full blocks directly to target address */
+			chunk_size = size / blksz;
+			n = blk_dread(win->blk_desc, blk, chunk_size, buf);
+			if (IS_ERR_VALUE(n))
+				return (int)n;
+			if (n < chunk_size)
+				return -EIO;
+			chunk_size *= blksz;
+		} else {
+			/* Unaligned head or tail, load window and retry */
+			err = fs_image_fill_window_mmc(blk);
+			if (err)
+				return err;
+			continue;
+		}
 
-	/*
-	 * Load full blocks directly to target address. This assumes that buf
-	 * is 32 bit aligned all the time. Our F&S images are always padded to
-	 * 16 bytes, so this should be no problem.
-	 */
-	if (size >= blksz) {
-		if ((unsigned long)buf & 3)
-			puts("### Aaargh! buf not 32-bit aligned!\n");
-		chunk_size = size / blksz;
-		n = blk_dread(blk_desc, offs, chunk_size, buf);
-		if (IS_ERR_VALUE(n))
-			return (int)n;
-		if (n < chunk_size)
-			return -EIO;
 		offs += chunk_size;
-		chunk_size *= blksz;
 		buf += chunk_size;
 		size -= chunk_size;
 	}
 
-	/*
-	 * If there are some bytes remaining, load one block to local buffer
-	 * and take these bytes from there.
-	 */
-	if (size > 0) {
-		n = blk_dread(blk_desc, offs, 1, local_buffer);
-		if (IS_ERR_VALUE(n))
-			return (int)n;
-		if (n < 1)
-			return -EIO;
-		memcpy(buf, local_buffer, size);
-	}
-
 	return 0;
 }
 
@@ -1679,6 +1850,9 @@ static int fs_image_set_hwpart_mmc(struct flash_info_spl *fi, int copy)
 	int err;
 	u8 hwpart = fi->hwpart[copy];
 
+	/* Blocks in the prefetch window belong to the previous hwpart */
+	mmc_window.count = 0;
+
 	err = blk_dselect_hwpart(fi->blk_desc, hwpart);
 	if (err)
 		printf("Cannot switch to hwpart %d\n", hwpart);
@@ -1720,6 +1894,8 @@ static int fs_image_get_flash_info_spl_mmc(struct flash_info_spl *fi)
 #endif
 
 	/* Set access functions */
+	mmc_window.blk_desc = fi->blk_desc;
+	mmc_window.count = 0;
 	fi->load = fs_image_gen_load_mmc;
 	fi->set_hwpart = fs_image_set_hwpart_mmc;
 
@@ -1781,6 +1957,8 @@ static int fs_image_loop(struct flash_info_spl *fi, struct fs_header_v1_0 *cfg,
 				err = fi->load(start, count, addr);
 				if (err)
 					return err;
+				if (mode == FSIMG_MODE_IMAGE)
+					fs_image_stream_data(addr, count);
 				addr += count;
 			}
 			start += count;
@@ -43,6 +43,9 @@ struct fs_header_v1_0 {			/* Size: 64 bytes */
 #define FSH_FLAGS_DESCR 0x8000		/* Description descr is present */
 #define FSH_FLAGS_CRC32 0x4000		/* CRC32 of image in type[12..15] */
 #define FSH_FLAGS_SECURE 0x2000		/* CRC32 of header in type[12..15] */
+#define FSH_FLAGS_SHA256 0x1000		/* SHA-256 of image in last 32 bytes */
+
+#define FSH_SHA256_SIZE 32		/* Size of SHA-256 digest */
 
 #define FSH_SIZE sizeof(struct fs_header_v1_0)
 
@@ -158,6 +161,11 @@ bool fs_image_is_secondary_uboot(void);
  */
 bool fs_image_find_cfg_in_ocram(void);
 
+#ifdef CONFIG_FS_IMAGE_SHA256
+/* Verify SHA-256 of given image */
+int fs_image_check_sha256(const struct fs_header_v1_0 *fsh);
+#endif
+
 /* Get count values from given device tree property and check alignment */
 int fs_image_get_fdt_val(void *fdt, int offs, const char *name, uint align,
 			 int count, uint *val);
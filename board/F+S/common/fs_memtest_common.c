@@ -17,8 +17,23 @@
 #include <asm/arch/clock.h>
 #include <asm/arch/ddr.h>
 #include <asm/arch/sys_proto.h>
+#ifdef CONFIG_FS_SPL_MEMTEST_PARALLEL
+#include <cpu_func.h>
+#include <asm/barriers.h>
+#include <asm/global_data.h>
+#include <asm/system.h>
+#include <asm/armv8/mmu.h>
+#include <linux/sizes.h>
+#endif
+#ifdef CONFIG_FS_DRAM_NEON
+#include "fs_dram_neon.h"
+#endif
 #include "fs_memtest_common.h"
 
+#ifdef CONFIG_FS_SPL_MEMTEST_PARALLEL
+DECLARE_GLOBAL_DATA_PTR;
+#endif
+
 typedef unsigned long ul;
 typedef unsigned long long ull;
 typedef unsigned long volatile ulv;
@@ -30,7 +45,72 @@ struct test {
     int (*fp)();
 };
 
-#define rand32() ((unsigned int) rand() | ( (unsigned int) rand() << 16))
+#ifdef CONFIG_FS_SPL_MEMTEST_PARALLEL
+#define MEMTEST_MAX_CORES 4
+#define MEMTEST_STACK_SIZE \
+	(CONFIG_FS_SPL_MEMTEST_STACK_SIZE / (MEMTEST_MAX_CORES - 1))
+
+/* Per-core state; secondary cores never print, the boot core reports */
+struct memtest_core {
+	ulv *bufa;			/* Slice of this core, first half */
+	ulv *bufb;			/* Slice of this core, second half */
+	size_t count;			/* Number of words in each half */
+	unsigned int seed;		/* Seed for rand_r() */
+	volatile int started;		/* Set when core is up and running */
+	volatile int test;		/* Index of test to run */
+	volatile unsigned int seq;	/* Incremented by boot core to start */
+	volatile unsigned int done;	/* Set to seq when test is finished */
+	volatile int result;		/* Result of test */
+	volatile unsigned int step;	/* Progress within test */
+	ul fail_addr;			/* First failing address or 0 */
+	ul fail_val;			/* Value read at fail_addr */
+	ul fail_exp;			/* Value expected at fail_addr */
+};
+
+static struct memtest_core cores[MEMTEST_MAX_CORES];
+static int parallel;
+
+/*
+ * Boot parameters for the secondary cores. They start with MMU and caches
+ * off, so this is flushed to memory before releasing the cores. Accessed
+ * from assembler code below, so do not change the order.
+ */
+struct memtest_boot {
+	u64 gd;				/* Global data pointer */
+	u64 ttbr;			/* MMU setup of boot core */
+	u64 tcr;
+	u64 sp[MEMTEST_MAX_CORES];	/* Initial stack pointer per core */
+};
+
+struct memtest_boot fs_memtest_boot __aligned(64);
+
+static unsigned int memtest_core_id(void)
+{
+	ul mpidr;
+
+	asm volatile("mrs %0, mpidr_el1" : "=r" (mpidr));
+
+	return mpidr & 0xff;
+}
+
+#define rand16() rand_r(&cores[memtest_core_id()].seed)
+#else
+#define MEMTEST_MAX_CORES 1
+#define memtest_core_id() 0
+#define rand16() rand()
+#endif
+
+/* Bytes and timer ticks spent in fill and compare, per core */
+struct memtest_bw {
+	u64 wr_bytes;
+	u64 wr_ticks;
+	u64 rd_bytes;
+	u64 rd_ticks;
+};
+
+static struct memtest_bw bw[MEMTEST_MAX_CORES];
+
+#define rand32() ((unsigned int) rand16() | ( (unsigned int) rand16() << 16))
 //#define rand32() ranval(&ctx)
 
 #define rand_ul() rand32()
@@ -61,16 +141,63 @@ union {
 static int show_progress = 1;
 static int wheel_pos;
 
+#ifdef CONFIG_FS_SPL_MEMTEST_PARALLEL
+/*
+ * In parallel mode, each core records its progress and its first failure.
+ * Only the boot core prints, showing the progress of the slowest core that is
+ * still busy with the current test.
+ */
+static int out_progress(unsigned int *j)
+{
+    unsigned int n;
+    unsigned int id;
+
+    if (!parallel)
+        return show_progress;
+
+    id = memtest_core_id();
+    if (j)
+        cores[id].step = *j;
+    if (id)
+        return 0;
+    if (j) {
+        for (n = 1; n < MEMTEST_MAX_CORES; n++) {
+            if (cores[n].started && (cores[n].done != cores[n].seq)
+                && (cores[n].step < *j))
+                *j = cores[n].step;
+        }
+    }
+
+    return show_progress;
+}
+
+static void set_failure(ulv *addr, ul val, ul exp)
+{
+    struct memtest_core *c = &cores[memtest_core_id()];
+
+    if (!c->fail_addr) {
+        c->fail_addr = (ul)addr;
+        c->fail_val = val;
+        c->fail_exp = exp;
+    }
+}
+#else
+static int out_progress(unsigned int *j)
+{
+    return show_progress;
+}
+#endif
+
 static void out_test_start(void)
 {
-    if (show_progress) {
+    if (out_progress(NULL)) {
         printf("           ");
     }
 }
 
 static void out_test_setting(unsigned int j)
 {
-    if (show_progress) {
+    if (out_progress(&j)) {
         printf("\b\b\b\b\b\b\b\b\b\b\b");
         printf("setting %3u", j);
     }
@@ -78,7 +205,7 @@ static void out_test_setting(unsigned int j)
 
 static void out_test_testing(unsigned int j)
 {
-    if (show_progress) {
+    if (out_progress(&j)) {
         printf("\b\b\b\b\b\b\b\b\b\b\b");
         printf("testing %3u", j);
     }
@@ -86,14 +213,14 @@ static void out_test_testing(unsigned int j)
 
 static void out_test_end(void)
 {
-    if (show_progress) {
+    if (out_progress(NULL)) {
         printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
     }
 }
 
 static void out_wheel_start(void)
 {
-    if (show_progress) {
+    if (out_progress(NULL)) {
         printf(" ");
         wheel_pos = 0;
     }
@@ -105,8 +232,8 @@ static void out_wheel_advance(unsigned int i)
     static const unsigned int n_chars = 4;
     char wheel_char[4] = {'-', '\\', '|', '/'};
 
-    if (show_progress) {
-        if (!(i % wheel_often)) {
+    if (!(i % wheel_often)) {
+        if (out_progress(NULL)) {
             printf("\b");
             printf("%c", wheel_char[++wheel_pos % n_chars]);
         }
@@ -115,7 +242,7 @@ static void out_wheel_advance(unsigned int i)
 
 static void out_wheel_end(void)
 {
-    if (show_progress) {
+    if (out_progress(NULL)) {
         printf("\b \b");
     }
 }
@@ -125,12 +252,27 @@ static void out_wheel_end(void)
 
 int compare_regions(ulv *bufa, ulv *bufb, size_t count) {
     int r = 0;
-    size_t i;
+    size_t i = 0;
     ulv *p1 = bufa;
     ulv *p2 = bufb;
-
-    for (i = 0; i < count; i++, p1++, p2++) {
+    struct memtest_bw *b = &bw[memtest_core_id()];
+    u64 start = get_ticks();
+
+#ifdef CONFIG_FS_DRAM_NEON
+    /* Skip to the first difference, the loop below only reports it */
+    i = fs_dram_compare((void *)bufa, (void *)bufb, count * sizeof(ul))
+        / sizeof(ul);
+    p1 += i;
+    p2 += i;
+#endif
+    for (; i < count; i++, p1++, p2++) {
         if (*p1 != *p2) {
+#ifdef CONFIG_FS_SPL_MEMTEST_PARALLEL
+            if (parallel) {
+                set_failure(p1, *p1, *p2);
+                return -1;
+            }
+#endif
                 printf( "FAILURE: 0x%08lx != 0x%08lx at offset 0x%08lx.\n",
                         (ul) *p1, (ul) *p2, (ul) (i * sizeof(ul)));
             /* printf("Skipping to next test..."); */
@@ -138,9 +280,30 @@ int compare_regions(ulv *bufa, ulv *bufb, size_t count) {
 			return r;
         }
     }
+    b->rd_ticks += get_ticks() - start;
+    b->rd_bytes += 2 * count * sizeof(ul);
     return r;
 }
 
+/* Fill both regions with alternating words even/odd */
+static void fill_regions(ulv *bufa, ulv *bufb, size_t count, ul even, ul odd)
+{
+    struct memtest_bw *b = &bw[memtest_core_id()];
+    u64 start = get_ticks();
+#ifdef CONFIG_FS_DRAM_NEON
+    fs_dram_fill((void *)bufa, count * sizeof(ul), even, odd);
+    fs_dram_fill((void *)bufb, count * sizeof(ul), even, odd);
+#else
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        *bufa++ = *bufb++ = (i % 2) == 0 ? even : odd;
+    }
+#endif
+    b->wr_ticks += get_ticks() - start;
+    b->wr_bytes += 2 * count * sizeof(ul);
+}
+
 int test_stuck_address(ulv *bufa, size_t count) {
     ulv *p1 = bufa;
     unsigned int j;
@@ -158,6 +321,13 @@ int test_stuck_address(ulv *bufa, size_t count) {
         p1 = (ulv *) bufa;
         for (i = 0; i < count; i++, p1++) {
             if (*p1 != (((j + i) % 2) == 0 ? (ul) p1 : ~((ul) p1))) {
+#ifdef CONFIG_FS_SPL_MEMTEST_PARALLEL
+                if (parallel) {
+                    set_failure(p1, *p1,
+                                ((j + i) % 2) == 0 ? (ul) p1 : ~((ul) p1));
+                    return -1;
+                }
+#endif
                 printf("FAILURE: possible bad address line at offset "
                         "0x%08lx.\n",
                         (ul) (i * sizeof(ul)));
@@ -278,21 +448,14 @@ int test_seqinc_comparison(ulv *bufa, ulv *bufb, size_t count) {
 }
 
 int test_solidbits_comparison(ulv *bufa, ulv *bufb, size_t count) {
-    ulv *p1 = bufa;
-    ulv *p2 = bufb;
     unsigned int j;
     ul q;
-    size_t i;
 
     out_test_start();
     for (j = 0; j < 64; j++) {
         q = (j % 2) == 0 ? UL_ONEBITS : 0;
         out_test_setting(j);
-        p1 = (ulv *) bufa;
-        p2 = (ulv *) bufb;
-        for (i = 0; i < count; i++) {
-            *p1++ = *p2++ = (i % 2) == 0 ? q : ~q;
-        }
+        fill_regions(bufa, bufb, count, q, ~q);
         out_test_testing(j);
         if (compare_regions(bufa, bufb, count)) {
             return -1;
@@ -303,21 +466,14 @@ int test_solidbits_comparison(ulv *bufa, ulv *bufb, size_t count) {
 }
 
 int test_checkerboard_comparison(ulv *bufa, ulv *bufb, size_t count) {
-    ulv *p1 = bufa;
-    ulv *p2 = bufb;
     unsigned int j;
     ul q;
-    size_t i;
 
     out_test_start();
     for (j = 0; j < 64; j++) {
         q = (j % 2) == 0 ? CHECKERBOARD1 : CHECKERBOARD2;
         out_test_setting(j);
-        p1 = (ulv *) bufa;
-        p2 = (ulv *) bufb;
-        for (i = 0; i < count; i++) {
-            *p1++ = *p2++ = (i % 2) == 0 ? q : ~q;
-        }
+        fill_regions(bufa, bufb, count, q, ~q);
         out_test_testing(j);
         if (compare_regions(bufa, bufb, count)) {
             return -1;
@@ -328,19 +484,12 @@ int test_checkerboard_comparison(ulv *bufa, ulv *bufb, size_t count) {
 }
 
 int test_blockseq_comparison(ulv *bufa, ulv *bufb, size_t count) {
-    ulv *p1 = bufa;
-    ulv *p2 = bufb;
     unsigned int j;
-    size_t i;
 
     out_test_start();
     for (j = 0; j < 256; j++) {
-        p1 = (ulv *) bufa;
-        p2 = (ulv *) bufb;
         out_test_setting(j);
-        for (i = 0; i < count; i++) {
-            *p1++ = *p2++ = (ul) UL_BYTE(j);
-        }
+        fill_regions(bufa, bufb, count, (ul) UL_BYTE(j), (ul) UL_BYTE(j));
         out_test_testing(j);
         if (compare_regions(bufa, bufb, count)) {
             return -1;
@@ -351,23 +500,18 @@ int test_blockseq_comparison(ulv *bufa, ulv *bufb, size_t count) {
 }
 
 int test_walkbits0_comparison(ulv *bufa, ulv *bufb, size_t count) {
-    ulv *p1 = bufa;
-    ulv *p2 = bufb;
     unsigned int j;
-    size_t i;
+    ul q;
 
     out_test_start();
     for (j = 0; j < UL_LEN * 2; j++) {
-        p1 = (ulv *) bufa;
-        p2 = (ulv *) bufb;
         out_test_setting(j);
-        for (i = 0; i < count; i++) {
-            if (j < UL_LEN) { /* Walk it up. */
-                *p1++ = *p2++ = ONE << j;
-            } else { /* Walk it back down. */
-                *p1++ = *p2++ = ONE << (UL_LEN * 2 - j - 1);
-            }
+        if (j < UL_LEN) { /* Walk it up. */
+            q = ONE << j;
+        } else { /* Walk it back down. */
+            q = ONE << (UL_LEN * 2 - j - 1);
         }
+        fill_regions(bufa, bufb, count, q, q);
         out_test_testing(j);
         if (compare_regions(bufa, bufb, count)) {
             return -1;
@@ -378,23 +522,18 @@ int test_walkbits0_comparison(ulv *bufa, ulv *bufb, size_t count) {
 }
 
 int test_walkbits1_comparison(ulv *bufa, ulv *bufb, size_t count) {
-    ulv *p1 = bufa;
-    ulv *p2 = bufb;
     unsigned int j;
-    size_t i;
+    ul q;
 
     out_test_start();
     for (j = 0; j < UL_LEN * 2; j++) {
-        p1 = (ulv *) bufa;
-        p2 = (ulv *) bufb;
         out_test_setting(j);
-        for (i = 0; i < count; i++) {
-            if (j < UL_LEN) { /* Walk it up. */
-                *p1++ = *p2++ = UL_ONEBITS ^ (ONE << j);
-            } else { /* Walk it back down. */
-                *p1++ = *p2++ = UL_ONEBITS ^ (ONE << (UL_LEN * 2 - j - 1));
-            }
+        if (j < UL_LEN) { /* Walk it up. */
+            q = UL_ONEBITS ^ (ONE << j);
+        } else { /* Walk it back down. */
+            q = UL_ONEBITS ^ (ONE << (UL_LEN * 2 - j - 1));
         }
+        fill_regions(bufa, bufb, count, q, q);
         out_test_testing(j);
         if (compare_regions(bufa, bufb, count)) {
             return -1;
@@ -405,29 +544,18 @@ int test_walkbits1_comparison(ulv *bufa, ulv *bufb, size_t count) {
 }
 
 int test_bitspread_comparison(ulv *bufa, ulv *bufb, size_t count) {
-    ulv *p1 = bufa;
-    ulv *p2 = bufb;
     unsigned int j;
-    size_t i;
+    ul q;
 
     out_test_start();
     for (j = 0; j < UL_LEN * 2; j++) {
-        p1 = (ulv *) bufa;
-        p2 = (ulv *) bufb;
         out_test_setting(j);
-        for (i = 0; i < count; i++) {
-            if (j < UL_LEN) { /* Walk it up. */
-                *p1++ = *p2++ = (i % 2 == 0)
-                    ? (ONE << j) | (ONE << (j + 2))
-                    : UL_ONEBITS ^ ((ONE << j)
-                                    | (ONE << (j + 2)));
-            } else { /* Walk it back down. */
-                *p1++ = *p2++ = (i % 2 == 0)
-                    ? (ONE << (UL_LEN * 2 - 1 - j)) | (ONE << (UL_LEN * 2 + 1 - j))
-                    : UL_ONEBITS ^ (ONE << (UL_LEN * 2 - 1 - j)
-                                    | (ONE << (UL_LEN * 2 + 1 - j)));
-            }
+        if (j < UL_LEN) { /* Walk it up. */
+            q = (ONE << j) | (ONE << (j + 2));
+        } else { /* Walk it back down. */
+            q = (ONE << (UL_LEN * 2 - 1 - j)) | (ONE << (UL_LEN * 2 + 1 - j));
         }
+        fill_regions(bufa, bufb, count, q, UL_ONEBITS ^ q);
         out_test_testing(j);
         if (compare_regions(bufa, bufb, count)) {
             return -1;
@@ -438,11 +566,8 @@ int test_bitspread_comparison(ulv *bufa, ulv *bufb, size_t count) {
 }
 
 int test_bitflip_comparison(ulv *bufa, ulv *bufb, size_t count) {
-    ulv *p1 = bufa;
-    ulv *p2 = bufb;
     unsigned int j, k;
     ul q;
-    size_t i;
 
     out_test_start();
     for (k = 0; k < UL_LEN; k++) {
@@ -450,11 +575,7 @@ int test_bitflip_comparison(ulv *bufa, ulv *bufb, size_t count) {
         for (j = 0; j < 8; j++) {
             q = ~q;
             out_test_setting(k * 8 + j);
-            p1 = (ulv *) bufa;
-            p2 = (ulv *) bufb;
-            for (i = 0; i < count; i++) {
-                *p1++ = *p2++ = (i % 2) == 0 ? q : ~q;
-            }
+            fill_regions(bufa, bufb, count, q, ~q);
             out_test_testing(k * 8 + j);
             if (compare_regions(bufa, bufb, count)) {
                 return -1;
@@ -491,6 +612,291 @@ struct test tests[] = {
     { NULL, NULL }
 };
 
+/* Show the write and read bandwidth, summed up over all cores */
+static void show_bandwidth(void)
+{
+	ulong tbclk = get_tbclk() / 1000;
+	ulong wr = 0, rd = 0;
+	unsigned int id;
+
+	for (id = 0; id < MEMTEST_MAX_CORES; id++) {
+		if (bw[id].wr_ticks)
+			wr += bw[id].wr_bytes * tbclk / bw[id].wr_ticks / 1000;
+		if (bw[id].rd_ticks)
+			rd += bw[id].rd_bytes * tbclk / bw[id].rd_ticks / 1000;
+	}
+	if (wr)
+		printf(" (write %lu.%02lu GB/s", wr / 1000, (wr % 1000) / 10);
+	if (rd)
+		printf("%sread %lu.%02lu GB/s", wr ? ", " : " (", rd / 1000,
+		       (rd % 1000) / 10);
+	if (wr || rd)
+		putc(')');
+}
+
+#ifdef CONFIG_FS_SPL_MEMTEST_PARALLEL
+/*
+ * Entry point of the secondary cores: enable SMP mode and FP/SIMD access (the
+ * test kernels may use NEON), set gd and stack.
+ */
+extern char fs_memtest_entry[];
+asm(
+"	.pushsection .text.fs_memtest_entry, \"ax\"\n"
+"	.balign	8\n"
+"	.global	fs_memtest_entry\n"
+"fs_memtest_entry:\n"
+"	mrs	x0, mpidr_el1\n"
+"	and	x0, x0, #0xff\n"
+"	mrs	x1, S3_1_C15_C2_1\n"	/* CPUECTLR_EL1 */
+"	orr	x1, x1, #(1 << 6)\n"	/* SMPEN */
+"	msr	S3_1_C15_C2_1, x1\n"
+"	mrs	x1, CurrentEL\n"
+"	cmp	x1, #0xc\n"		/* EL3 */
+"	b.ne	1f\n"
+"	msr	cptr_el3, xzr\n"	/* Clear TFP */
+"	b	2f\n"
+"1:	cmp	x1, #0x8\n"		/* EL2 */
+"	b.ne	2f\n"
+"	mov	x1, #0x33ff\n"
+"	msr	cptr_el2, x1\n"	/* Clear TFP */
+"2:	mov	x1, #(3 << 20)\n"
+"	msr	cpacr_el1, x1\n"	/* FPEN */
+"	isb\n"
+"	adrp	x1, fs_memtest_boot\n"
+"	add	x1, x1, :lo12:fs_memtest_boot\n"
+"	ldr	x18, [x1]\n"
+"	add	x2, x1, x0, lsl #3\n"
+"	ldr	x2, [x2, #24]\n"
+"	mov	sp, x2\n"
+"	b	fs_memtest_secondary\n"
+"	.popsection\n"
+);
+
+/* Run one test on the slice of the given core */
+static int memtest_run(struct memtest_core *c, int test)
+{
+	/* clear buffer */
+	memset((void *)c->bufa, 255, c->count * 2 * sizeof(ul));
+
+	return tests[test].fp(c->bufa, c->bufb, c->count);
+}
+
+/* Main loop of the secondary cores, waiting for tests to run */
+void fs_memtest_secondary(unsigned int id)
+{
+	struct memtest_core *c = &cores[id];
+	unsigned int seq = 0;
+
+	/* Use the translation tables of the boot core for cached access */
+	__asm_invalidate_tlb_all();
+	set_ttbr_tcr_mair(current_el(), fs_memtest_boot.ttbr,
+			  fs_memtest_boot.tcr, MEMORY_ATTRIBUTES);
+	set_sctlr(get_sctlr() | CR_M | CR_C | CR_I);
+
+	c->started = 1;
+	for (;;) {
+		while (c->seq == seq)
+			asm volatile("wfe");
+		seq = c->seq;
+		dmb();
+		c->result = memtest_run(c, c->test);
+		dmb();
+		c->done = seq;
+		asm volatile("dsb sy; sev" : : : "memory");
+	}
+}
+
+/*
+ * GPC registers for the A53 cores. struct gpc_reg has the i.MX8MM layout, but
+ * the power up trigger is at a different offset on i.MX8MP. See gpc_reg.h of
+ * the respective SoC in ATF.
+ */
+#define GPC_LPCR_A53_AD		0x004
+#ifdef CONFIG_IMX8MP
+#define GPC_CPU_PGC_UP_TRG	0x0d0
+#else
+#define GPC_CPU_PGC_UP_TRG	0x0f0
+#endif
+#define GPC_COREx_PGC_PCR(id)	(0x800 + (id) * 0x40)
+
+/* Power up and release a secondary core, like ATF does on PSCI CPU_ON */
+static void memtest_start_core(unsigned int id)
+{
+	struct src *src = (struct src *)SRC_BASE_ADDR;
+	void __iomem *gpc = (void __iomem *)GPC_BASE_ADDR;
+	u32 *gpr = &src->gpr1 + 2 * id;
+	ulong entry = (ulong)fs_memtest_entry >> 2;
+	ulong time;
+
+	/* Set the reset vector of the core */
+	writel((entry >> 22) & 0xffff, gpr);
+	writel(entry & 0x3fffff, gpr + 1);
+
+	/* Clear the WFI power down bit of the core */
+	clrbits_le32(gpc + GPC_LPCR_A53_AD,
+		     (id < 2) ? BIT(id * 2) : BIT(id * 2 + 12));
+
+	/* Power up the core while holding it in reset, then release it */
+	clrbits_le32(&src->a53rcr1, BIT(id));
+	setbits_le32(gpc + GPC_COREx_PGC_PCR(id), 1);
+	setbits_le32(gpc + GPC_CPU_PGC_UP_TRG, BIT(id));
+	time = get_timer(0);
+	while (readl(gpc + GPC_CPU_PGC_UP_TRG) & BIT(id)) {
+		if (get_timer(time) > 100)
+			break;
+	}
+	clrbits_le32(gpc + GPC_COREx_PGC_PCR(id), 1);
+	setbits_le32(&src->a53rcr1, BIT(id));
+}
+
+/*
+ * Hold a secondary core in reset again. ATF asserts the reset itself before
+ * it powers up a core on PSCI CPU_ON, so the core can be used later.
+ */
+static void memtest_stop_core(unsigned int id)
+{
+	struct src *src = (struct src *)SRC_BASE_ADDR;
+
+	clrbits_le32(&src->a53rcr1, BIT(id));
+	cores[id].started = 0;
+}
+
+/* Return the number of A53 cores of this CPU variant */
+static unsigned int memtest_get_cores(void)
+{
+	if (is_imx8mms() || is_imx8mmsl() || is_imx8mns() || is_imx8mnsl()
+	    || is_imx8mnus())
+		return 1;
+	if (is_imx8mmd() || is_imx8mmdl() || is_imx8mnd() || is_imx8mndl()
+	    || is_imx8mnud() || is_imx8mpd())
+		return 2;
+
+	return MEMTEST_MAX_CORES;
+}
+
+/* Stop all secondary cores and continue on the boot core only */
+static void memtest_stop_parallel(unsigned int ncores)
+{
+	unsigned int id;
+
+	for (id = 1; id < ncores; id++)
+		memtest_stop_core(id);
+	parallel = 0;
+}
+
+/*
+ * Split DRAM into one slice per core and start the secondary cores. Return
+ * the number of cores that take part in the test.
+ */
+static unsigned int memtest_start_parallel(size_t start, size_t memsize)
+{
+	unsigned int ncores = memtest_get_cores();
+	unsigned int id;
+	size_t slice, len;
+	ulong time;
+
+	if (ncores < 2)
+		return 1;
+
+	/* Forget the state of a previous run */
+	memset(cores, 0, sizeof(cores));
+
+	/* The last core also gets the remainder */
+	slice = (memsize / ncores) & ~(size_t)(SZ_4K - 1);
+	for (id = 0; id < ncores; id++) {
+		struct memtest_core *c = &cores[id];
+
+		len = (id == ncores - 1) ? memsize - id * slice : slice;
+		c->bufa = (ulv *)(start + id * slice);
+		c->count = len / 2 / sizeof(ul);
+		c->bufb = c->bufa + c->count;
+		c->seed = memsize + id;
+	}
+
+	fs_memtest_boot.gd = (u64)gd;
+	fs_memtest_boot.ttbr = gd->arch.tlb_addr;
+	fs_memtest_boot.tcr = get_tcr(current_el(), NULL, NULL);
+	for (id = 1; id < ncores; id++)
+		fs_memtest_boot.sp[id] = CONFIG_FS_SPL_MEMTEST_STACK
+			+ id * MEMTEST_STACK_SIZE;
+
+	/* The secondary cores start with caches off */
+	flush_dcache_range((ulong)&fs_memtest_boot,
+			   (ulong)(&fs_memtest_boot + 1));
+
+	for (id = 1; id < ncores; id++)
+		memtest_start_core(id);
+
+	time = get_timer(0);
+	for (id = 1; id < ncores; id++) {
+		while (!cores[id].started) {
+			if (get_timer(time) > 100) {
+				printf("Core %u did not start, using boot core only\n",
+				       id);
+				memtest_stop_parallel(ncores);
+				return 1;
+			}
+		}
+	}
+	parallel = 1;
+
+	return ncores;
+}
+
+/* Run a test on all cores in parallel, then report failures per core */
+static int memtest_run_parallel(int test, unsigned int ncores)
+{
+	unsigned int id;
+	ulong time, timeout;
+	int ret = 0;
+
+	for (id = 0; id < ncores; id++) {
+		cores[id].fail_addr = 0;
+		cores[id].step = 0;
+		cores[id].test = test;
+	}
+	dmb();
+	for (id = 1; id < ncores; id++)
+		cores[id].seq++;
+	asm volatile("dsb sy; sev" : : : "memory");
+
+	/* The boot core tests its own slice meanwhile */
+	time = get_timer(0);
+	cores[0].result = memtest_run(&cores[0], test);
+
+	/*
+	 * All slices have about the same size, so the other cores should be
+	 * done shortly after the boot core. Do not wait with wfe here, a core
+	 * that hangs would never send an event.
+	 */
+	timeout = 2 * get_timer(time) + 1000;
+	time = get_timer(0);
+	for (id = 1; id < ncores; id++) {
+		while (cores[id].done != cores[id].seq) {
+			if (get_timer(time) > timeout) {
+				printf("FAILURE: core %u does not respond.\n",
+				       id);
+				cores[id].result = -1;
+				break;
+			}
+		}
+	}
+	dmb();
+
+	for (id = 0; id < ncores; id++) {
+		if (!cores[id].result)
+			continue;
+		ret = -1;
+		if (cores[id].fail_addr)
+			printf("FAILURE on core %u: 0x%08lx != 0x%08lx at 0x%08lx.\n",
+			       id, cores[id].fail_val, cores[id].fail_exp,
+			       cores[id].fail_addr);
+	}
+
+	return ret;
+}
+#endif /* CONFIG_FS_SPL_MEMTEST_PARALLEL */
+
 void memtester(size_t dramStartAddress, size_t memsize)
 {
     ul i;
@@ -498,6 +904,11 @@ void memtester(size_t dramStartAddress, size_t memsize)
     ulv *bufa, *bufb;
     ul testmask = 0;
 	int exit_code = 0;
+	int ret;
+	ulong time;
+#ifdef CONFIG_FS_SPL_MEMTEST_PARALLEL
+	unsigned int ncores = 1;
+#endif
 
 	srand(memsize);
 
@@ -510,18 +921,32 @@ void memtester(size_t dramStartAddress, size_t memsize)
 
     printf("bufa = %08lx, bufb = %08lx, count = %lx\n", (ul)bufa, (ul)bufb, count);
 
+	time = get_timer(0);
     printf("\n  %-20s: ", "Stuck Address");
-    if (!test_stuck_address((ulv *)dramStartAddress, memsize / sizeof(ul))) {
+	/*
+	 * Always on the boot core only: address line faults are only found if
+	 * the whole range is written before it is read back.
+	 */
+	ret = test_stuck_address((ulv *)dramStartAddress,
+				 memsize / sizeof(ul));
+    if (!ret) {
         printf("ok\r\n");
     } else {
         exit_code |= EXIT_FAIL_ADDRESSLINES;
     }
 
+#ifdef CONFIG_FS_SPL_MEMTEST_PARALLEL
+	cores[0].seed = memsize;
+	if (!exit_code) {
+		ncores = memtest_start_parallel(dramStartAddress, memsize);
+		if (parallel)
+			printf("  running on %u cores in parallel\n", ncores);
+	}
+#endif
+
     for (i=0;;i++) {
 		if (exit_code || !tests[i].name)
 			break;
-        /* clear buffer */
-        memset((void *) bufa, 255, memsize);
         /* If using a custom testmask, only run this test if the
         bit corresponding to this test was set by the user.
         */
@@ -529,19 +954,36 @@ void memtester(size_t dramStartAddress, size_t memsize)
             continue;
         }
         printf("  %-20s: ", tests[i].name);
-        if (!tests[i].fp(bufa, bufb, count))
+		memset(bw, 0, sizeof(bw));
+#ifdef CONFIG_FS_SPL_MEMTEST_PARALLEL
+		if (parallel) {
+			ret = memtest_run_parallel(i, ncores);
+		} else
+#endif
+		{
+			/* clear buffer */
+			memset((void *) bufa, 255, memsize);
+			ret = tests[i].fp(bufa, bufb, count);
+		}
+        if (!ret)
         {
-            printf("ok\n");
+            printf("ok");
+            show_bandwidth();
+            putc('\n');
         }
         else
         {
             exit_code |= EXIT_FAIL_OTHERTEST;
         }
     }
+	time = get_timer(time);
+#ifdef CONFIG_FS_SPL_MEMTEST_PARALLEL
+	if (parallel)
+		memtest_stop_parallel(ncores);
+#endif
 	if (exit_code)
    		printf("\nDram Test FAILED.\n\n");
 	else 
-		printf("\nDram Test OK.\n\n");
+		printf("\nDram Test OK (%lu.%03lu s).\n\n", time / 1000,
+		       time % 1000);
 }
-
-
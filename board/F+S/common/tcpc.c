@@ -4,6 +4,7 @@
  * SPDX-License-Identifier:	GPL-2.0+
  */
 #include <common.h>
+#include <bootstage.h>
 #include <i2c.h>
 #include <time.h>
 #include <dm.h>
@@ -1049,6 +1050,7 @@ int tcpc_init(struct tcpc_port *port, struct tcpc_port_config config, ss_mux_sel
 	tcpc_clear_alert(port, 0xffff);
 
 	tcpc_print_log(port);
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "tcpc_init");
 
 	return 0;
 }
@@ -12,6 +12,7 @@
 
 #include <common.h>
 #include <spl.h>
+#include <bootstage.h>			/* bootstage_mark_name() */
 #include <asm/io.h>
 #include <errno.h>
 #include <asm/io.h>
@@ -292,6 +293,7 @@ void board_init_f(ulong dummy)
 	}
 
 	printf("DDRInfo: RAM initialization success.\n");
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "fs_spl_dram_init");
 
 	/* initalize ram area with zero before set */
 	memset(pargs, 0x0, sizeof(struct fs_nboot_args));
@@ -1704,6 +1704,9 @@ int ft_board_setup(void *fdt, struct bd_info *bd)
 	int minc, maxc;
 	int id = 0;
 
+	/* Record all fixups and rebuild the device tree only once */
+	fs_fdt_begin(fdt);
+
 	/* The following stuff is only set in Linux device tree */
 	/* Disable RTC85063 if it is not available */
 	if (!(features & FEAT_RTC85063))
@@ -1790,7 +1793,9 @@ int ft_board_setup(void *fdt, struct bd_info *bd)
 		printf("## Wrong cpu temp grade values read! Keeping defaults from device tree\n");
 	}
 
-	return do_fdt_board_setup_common(fdt);
+	do_fdt_board_setup_common(fdt);
+
+	return fs_fdt_commit(fdt);
 }
 
 #ifdef CONFIG_FASTBOOT_STORAGE_MMC
@@ -13,6 +13,7 @@
 
 #include <common.h>
 #include <spl.h>
+#include <bootstage.h>			/* bootstage_mark_name() */
 #include <hang.h>
 #include <asm/io.h>
 #include <errno.h>
@@ -467,6 +468,7 @@ static void basic_init(const char *layout_name)
 
 	fs_board_early_init();
 	power_init_board();
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "fs_spl_basic_init");
 }
 
 void board_init_f(ulong dummy)
@@ -529,6 +531,8 @@ void board_init_f(ulong dummy)
 		fs_image_all_sdp(need_cfg, basic_init);
 	}
 
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "fs_spl_load_system");
+
 	/* If running on secondary SPL, mark BOARD-CFG to pass info to U-Boot */
 	if (secondary)
 		fs_image_mark_secondary();
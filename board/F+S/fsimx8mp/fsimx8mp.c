@@ -443,6 +443,9 @@ int ft_board_setup(void *fdt, struct bd_info *bd)
 	__maybe_unused uint32_t temp_range;
 	struct cfg_info *info = fs_board_get_cfg_info();
 
+	/* Record all fixups and rebuild the device tree only once */
+	fs_fdt_begin(fdt);
+
 	/* get CPU temp grade from the fuses */
 	temp_range = get_cpu_temp_grade(&minc, &maxc);
 
@@ -592,7 +595,7 @@ int ft_board_setup(void *fdt, struct bd_info *bd)
 
 		/* delete any existing wlan sub-node in sd_(x) interface */
 		nodeoffset = fdt_path_offset(fdt, "wlan");
-		fdt_del_node(fdt, nodeoffset);
+		fs_fdt_del_node(fdt, nodeoffset);
 
 		switch (fs_board_get_type()) {
 			case BT_PICOCOREMX8MP:
@@ -611,11 +614,11 @@ int ft_board_setup(void *fdt, struct bd_info *bd)
 				!strcmp(usdhc_name, "sd_c")) {
 			nodeoffset = fdt_path_offset(fdt, usdhc_name);
 			/* delete properties for wlan */
-			fdt_delprop(fdt, nodeoffset, "mmc-pwrseq");
-			fdt_delprop(fdt, nodeoffset, "non-removable");
-			fdt_delprop(fdt, nodeoffset, "pm-ignore-notify");
-			fdt_delprop(fdt, nodeoffset, "cap-power-off-card");
-			fdt_delprop(fdt, nodeoffset, "keep-power-in-suspend");
+			fs_fdt_delprop(fdt, nodeoffset, "mmc-pwrseq");
+			fs_fdt_delprop(fdt, nodeoffset, "non-removable");
+			fs_fdt_delprop(fdt, nodeoffset, "pm-ignore-notify");
+			fs_fdt_delprop(fdt, nodeoffset, "cap-power-off-card");
+			fs_fdt_delprop(fdt, nodeoffset, "keep-power-in-suspend");
 		}
 	}
 
@@ -665,7 +668,9 @@ int ft_board_setup(void *fdt, struct bd_info *bd)
 		printf("## Wrong cpu temp grade values read! Keeping defaults from device tree\n");
 	}
 
-	return do_fdt_board_setup_common(fdt);
+	do_fdt_board_setup_common(fdt);
+
+	return fs_fdt_commit(fdt);
 }
 #endif
 
@@ -16,6 +16,7 @@
 #include <cpu_func.h>
 #include <hang.h>
 #include <spl.h>
+#include <bootstage.h>			/* bootstage_mark_name() */
 #include <asm/io.h>
 #include <errno.h>
 #include <asm/io.h>
@@ -495,6 +496,7 @@ static void basic_init(const char *layout_name)
 	fs_spl_init_boot_dev(boot_dev, "BOARD-CFG");
 
 	power_init_board();
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "fs_spl_basic_init");
 }
 
 int spl_mmc_emmc_boot_partition(struct mmc *mmc)
@@ -577,6 +579,8 @@ void board_init_f(ulong dummy)
 		fs_image_all_sdp(need_cfg, basic_init);
 	}
 
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "fs_spl_load_system");
+
 	/* If running on secondary SPL, mark BOARD-CFG to pass info to U-Boot */
 	if (secondary)
 		fs_image_mark_secondary();
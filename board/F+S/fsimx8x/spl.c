@@ -7,6 +7,7 @@
 #include <common.h>
 #include <dm.h>
 #include <spl.h>
+#include <bootstage.h>			/* bootstage_mark_name() */
 #include <asm/arch/clock.h>
 #include <asm/arch/sci/sci.h>
 #include <asm/arch/imx8-pins.h>
@@ -210,7 +211,7 @@ static void basic_init(const char *layout_name)
 
 	/* We need to have the boot device pads active when starting U-Boot */
 	fs_spl_init_boot_dev(boot_dev, "BOARD-CFG");
-
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "fs_spl_basic_init");
 }
 
 static void spl_quiesce_devices(void)
@@ -299,6 +300,8 @@ void board_init_f(ulong dummy)
 		fs_image_all_sdp(need_cfg, basic_init);
 	}
 
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "fs_spl_load_system");
+
 	/* If running on secondary SPL, mark BOARD-CFG to pass info to U-Boot */
 	if (secondary)
 		fs_image_mark_secondary();
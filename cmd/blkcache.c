@@ -14,30 +14,44 @@ static int blkc_show(struct cmd_tbl *cmdtp, int flag,
 		     int argc, char *const argv[])
 {
 	struct block_cache_stats stats;
+	struct block_cache_dev_stats dev_stats;
+	int i;
+
+	for (i = 0; !blkcache_dev_stats(i, &dev_stats); i++) {
+		printf("%s %d: hits: %u, misses: %u, evictions: %u, "
+		       "read-ahead: %u blocks\n",
+		       blk_get_if_type_name(dev_stats.iftype), dev_stats.devnum,
+		       dev_stats.hits, dev_stats.misses, dev_stats.evictions,
+		       dev_stats.readahead);
+	}
+
 	blkcache_stats(&stats);
 
 	printf("hits: %u\n"
 	       "misses: %u\n"
+	       "evictions: %u\n"
 	       "entries: %u\n"
+	       "bytes: %lu\n"
 	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
-	       stats.max_blocks_per_entry, stats.max_entries);
+	       "max cache bytes: %lu\n",
+	       stats.hits, stats.misses, stats.evictions, stats.entries,
+	       stats.bytes, stats.max_blocks_per_entry, stats.max_bytes);
 	return 0;
 }
 
 static int blkc_configure(struct cmd_tbl *cmdtp, int flag,
 			  int argc, char *const argv[])
 {
-	unsigned blocks_per_entry, max_entries;
+	unsigned blocks_per_entry;
+	unsigned long max_bytes;
 	if (argc != 3)
 		return CMD_RET_USAGE;
 
 	blocks_per_entry = simple_strtoul(argv[1], 0, 0);
-	max_entries = simple_strtoul(argv[2], 0, 0);
-	blkcache_configure(blocks_per_entry, max_entries);
-	printf("changed to max of %u entries of %u blocks each\n",
-	       max_entries, blocks_per_entry);
+	max_bytes = simple_strtoul(argv[2], 0, 0);
+	blkcache_configure(blocks_per_entry, max_bytes);
+	printf("changed to max of %lu bytes in entries of %u blocks each\n",
+	       max_bytes, blocks_per_entry);
 	return 0;
 }
 
@@ -83,5 +97,5 @@ U_BOOT_CMD(
 	blkcache, 4, 0, do_blkcache,
 	"block cache diagnostics and control",
 	"show - show and reset statistics\n"
-	"blkcache configure blocks entries\n"
+	"blkcache configure blocks bytes\n"
 );
@@ -1378,6 +1378,9 @@ const char *lcd_bitmap(const wininfo_t *pwi, XYPOS x, XYPOS y, u_long addr)
 	if (ii.yend + y > ymax)
 		ii.yend = ymax - y;
 
+	/* Mark whole bitmap area as modified, the rows don't do this */
+	lcd_damage(pwi, x, y, x + ii.xend - ii.xpix - 1, y + ii.yend - 1);
+
 	/* Actually draw the bitmap */
 	return bmtype_tab[ii.bi.type].draw_bm(&ii, addr);
 }
@@ -1783,7 +1786,7 @@ static int lcd_test(const wininfo_t *pwi, u_int pattern)
 /************************************************************************/
 
 /* Handle draw command */
-static int do_draw(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+static int draw_cmd(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 {
 	wininfo_t *pwi;
 	const vidinfo_t *pvi;
@@ -2138,6 +2141,19 @@ static int do_draw(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 	return 0;
 }
 
+/* Each draw command is a batch of its own, i.e. modified regions are flushed
+   from D-cache at the end, unless an outer batch is active (lcd batch) */
+static int do_draw(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+	int ret;
+
+	lcd_batch_begin();
+	ret = draw_cmd(cmdtp, flag, argc, argv);
+	lcd_batch_end();
+
+	return ret;
+}
+
 #if defined(CONFIG_CMD_DRAW) || defined(CONFIG_CMD_ADRAW)
 /* If only CONFIG_CMD_ADRAW and not CONFIG_CMD_DRAW is set, call as "draw" */
 U_BOOT_CMD(
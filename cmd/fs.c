@@ -41,6 +41,26 @@ U_BOOT_CMD(
 	"      If 'pos' is 0 or omitted, the file is read from the start."
 )
 
+#ifdef CONFIG_GZIP
+static int do_gzload_wrapper(struct cmd_tbl *cmdtp, int flag, int argc,
+			     char *const argv[])
+{
+	return do_gzload(cmdtp, flag, argc, argv, FS_TYPE_ANY);
+}
+
+U_BOOT_CMD(
+	gzload,	6,	0,	do_gzload_wrapper,
+	"load and decompress gzipped file from a filesystem",
+	"<interface> [<dev[:part]> [<addr> [<filename> [maxsize]]]]\n"
+	"    - Load gzipped file 'filename' from partition 'part' on device\n"
+	"      type 'interface' instance 'dev' and decompress it to address\n"
+	"      'addr' in memory. The file is read in chunks and each chunk is\n"
+	"      decompressed immediately, so no intermediate buffer for the\n"
+	"      whole compressed file is needed.\n"
+	"      'maxsize' limits the size of the uncompressed data."
+)
+#endif
+
 static int do_save_wrapper(struct cmd_tbl *cmdtp, int flag, int argc,
 			   char *const argv[])
 {
@@ -254,6 +254,10 @@ struct flash_info {
 	unsigned int write_pos;		/* temp contains data up to this pos */
 	unsigned int bb_extra_offs;	/* Extra offset due to bad blocks */
 	u8 temp_fill;			/* Default value for temp buffer */
+	bool differential;		/* Skip data that is already in flash */
+	u8 *verify;			/* Buffer for reading back flash data */
+	unsigned int bytes_written;	/* Statistics for differential save */
+	unsigned int bytes_skipped;
 	enum boot_device boot_dev;	/* Device to boot from */
 	const char *boot_dev_name;	/* Boot device as string */
 	struct flash_ops *ops;		/* Access functions for NAND/MMC */
@@ -275,6 +279,9 @@ union any_header {
 	struct fdt_header fdt;
 };
 
+/* Size of the buffer for reading back data in differential save */
+#define VERIFY_SIZE 0x10000
+
 /* Argument of option -e in fsimage save */
 static unsigned int early_support_index;
 
@@ -458,6 +465,10 @@ static void fs_image_crc_all(unsigned long addr, unsigned int offs,
 
 	if (fs_image_check_crc32(fsh) < 0)
 		crc_valid = false;
+#ifdef CONFIG_FS_IMAGE_SHA256
+	if (fs_image_check_sha256(fsh) < 0)
+		crc_valid = false;
+#endif
 
 	pcs = (u32 *)&fsh->type[12];
 
@@ -830,6 +841,16 @@ static int fs_image_check_all_crc32(struct fs_header_v1_0 *fsh)
 		return err;
 	}
 
+#ifdef CONFIG_FS_IMAGE_SHA256
+	err = fs_image_check_sha256(fsh);
+	if (err < 0) {
+		puts(" BAD SHA-256");
+		return err;
+	}
+	if (err)
+		debug("  - %s (SHA-256 ok)\n", fsh->type);
+#endif
+
 	remaining = fs_image_get_size(fsh++, false);
 	while (remaining > 0) {
 		if (!fs_image_is_fs_image(fsh))
@@ -922,6 +943,16 @@ static int fs_image_validate(struct fs_header_v1_0 *fsh, const char *type,
 		return err;
 	}
 
+#ifdef CONFIG_FS_IMAGE_SHA256
+	err = fs_image_check_sha256(fsh);
+	if (err < 0) {
+		puts("Error: BAD SHA-256\n");
+		return err;
+	}
+	if (err)
+		puts("SHA-256 ok\n");
+#endif
+
 	return 0;
 }
 
@@ -1483,6 +1514,78 @@ static int fs_image_save_sub(struct flash_info *fi, uint offs, uint size,
 	return 0;
 }
 
+/* Get buffer to read back flash data for comparison; allocate on first use */
+static u8 *fs_image_get_verify_buf(struct flash_info *fi)
+{
+	if (!fi->verify) {
+		fi->verify = malloc(VERIFY_SIZE);
+		if (!fi->verify)
+			puts("Cannot allocate verify buffer\n");
+	}
+
+	return fi->verify;
+}
+
+/* Return true if the data in flash at offs is the same as in buf */
+static bool fs_image_is_sub_unchanged(struct flash_info *fi, uint offs,
+				      uint size, uint lim, uint flags,
+				      const u8 *buf)
+{
+	unsigned int chunk_mask = fi->temp_size - 1;
+	unsigned int pos = offs & chunk_mask;
+	unsigned int chunk_size;
+	unsigned int read_size;
+	u8 *verify = fs_image_get_verify_buf(fi);
+
+	if (!verify)
+		return false;
+
+	/* Reading is only possible from page/block boundaries */
+	offs -= pos;
+	while (size) {
+		chunk_size = min(VERIFY_SIZE - pos, size);
+		read_size = (pos + chunk_size + chunk_mask) & ~chunk_mask;
+		if (fi->ops->read(fi, offs, read_size, lim, flags, verify))
+			return false;
+		if (memcmp(verify + pos, buf, chunk_size))
+			return false;
+		offs += read_size;
+		buf += chunk_size;
+		size -= chunk_size;
+		pos = 0;
+	}
+
+	return true;
+}
+
+/* Return true if all sub-images of the region are already in flash */
+static bool fs_image_is_region_unchanged(struct flash_info *fi, int copy,
+					 struct region_info *ri)
+{
+	struct sub_info *s;
+	struct storage_info *si = ri->si;
+	unsigned int lim = si->start[copy] + si->size;
+
+	fi->bb_extra_offs = 0;
+	for (s = ri->sub; s < ri->sub + ri->count; s++) {
+		if (!fs_image_is_sub_unchanged(fi, si->start[copy] + s->offset,
+					       s->size, lim, s->flags, s->img))
+			return false;
+	}
+
+	return true;
+}
+
+/* Show how much data was actually written in a differential save */
+static void fs_image_show_diff_stats(struct flash_info *fi)
+{
+	if (!fi->differential)
+		return;
+
+	printf("\nDifferential save: 0x%x bytes written, 0x%x bytes"
+	       " unchanged\n", fi->bytes_written, fi->bytes_skipped);
+}
+
 /* Save the given region to flash */
 static int fs_image_save_region(struct flash_info *fi, int copy,
 				struct region_info *ri)
@@ -1502,6 +1605,18 @@ static int fs_image_save_region(struct flash_info *fi, int copy,
 	if (err)
 		return err;
 
+	/*
+	 * In a differential save, leave the region alone if it already has
+	 * the same content. This avoids erasing and rewriting the region and
+	 * also keeps this copy valid all the time.
+	 */
+	if (fi->differential && fs_image_is_region_unchanged(fi, copy, ri)) {
+		for (s = ri->sub; s < ri->sub + ri->count; s++)
+			fi->bytes_skipped += s->size;
+		printf("  %s unchanged, skipping\n", si->type);
+		return 0;
+	}
+
 repeat:
 	/* Clear the temp buffer (write cache) */
 	fs_image_drop_temp(fi);
@@ -2126,6 +2241,7 @@ static int fs_image_write_nand(struct flash_info *fi, uint offs, uint size,
 		debug("  - Adding 0x%lx to bad block offset\n", bb_extra);
 		fi->bb_extra_offs += bb_extra;
 	}
+	fi->bytes_written += wsize;
 
 	return 0;
 }
@@ -2783,15 +2899,45 @@ static int fs_image_write_mmc(struct flash_info *fi, uint offs, uint size,
 	lbaint_t blk = offs / blksz;
 	lbaint_t blk_count = (size + blksz - 1) / blksz;;
 
+	lbaint_t chunk_count;
+	u8 *verify = NULL;
+
 	/* Bad block handling is done by eMMC controller */
 	debug("  -> mmc_write to offs 0x%x (block 0x" LBAF ") size 0x%x\n",
 	      offs, blk, size);
 
-	count = blk_dwrite(fi->blk_desc, blk, blk_count, buf);
-	if (count < blk_count)
-		return -EIO;
-	else if (IS_ERR_VALUE(count))
-		return (int)count;
+	/*
+	 * In a differential save, read back the data in chunks and only
+	 * write chunks that differ. If reading fails, simply write.
+	 */
+	if (fi->differential)
+		verify = fs_image_get_verify_buf(fi);
+
+	while (blk_count) {
+		chunk_count = blk_count;
+		if (verify) {
+			chunk_count = min(chunk_count,
+					  (lbaint_t)(VERIFY_SIZE / blksz));
+			count = blk_dread(fi->blk_desc, blk, chunk_count,
+					  verify);
+			if ((count == chunk_count)
+			    && !memcmp(verify, buf, chunk_count * blksz)) {
+				fi->bytes_skipped += chunk_count * blksz;
+				goto next;
+			}
+		}
+
+		count = blk_dwrite(fi->blk_desc, blk, chunk_count, buf);
+		if (count < chunk_count)
+			return -EIO;
+		else if (IS_ERR_VALUE(count))
+			return (int)count;
+		fi->bytes_written += chunk_count * blksz;
+next:
+		blk += chunk_count;
+		blk_count -= chunk_count;
+		buf += chunk_count * blksz;
+	}
 
 	return 0;
 }
@@ -3109,11 +3255,12 @@ static void fs_image_put_flash_info(struct flash_info *fi)
 {
 	fi->ops->put_flash(fi);
 	free(fi->temp);
+	free(fi->verify);
 }
 
 
 /* Handle fsimage save if loaded image is a U-Boot image */
-static int do_fsimage_save_uboot(ulong addr, bool force)
+static int do_fsimage_save_uboot(ulong addr, bool force, bool differential)
 {
 	void *fdt;
 	struct sub_info sub;
@@ -3145,7 +3292,9 @@ static int do_fsimage_save_uboot(ulong addr, bool force)
 		return CMD_RET_FAILURE;
 
 	/* ### TODO: set copy depending on Set A or B (or redundant copy) */
+	fi.differential = differential;
 	failed = fs_image_save_uboot(&fi, &ri);
+	fs_image_show_diff_stats(&fi);
 	fs_image_put_flash_info(&fi);
 
 	return fs_image_show_save_status(failed, "U-Boot");
@@ -3410,6 +3559,7 @@ static int do_fsimage_save(struct cmd_tbl *cmdtp, int flag, int argc,
 	int failed;
 	unsigned long addr;
 	bool force = false;
+	bool differential = false;
 	unsigned int woffset;
 
 	early_support_index = 0;
@@ -3439,6 +3589,10 @@ static int do_fsimage_save(struct cmd_tbl *cmdtp, int flag, int argc,
 			force = true;
 			argv++;
 			argc--;
+		} else if (!strcmp(argv[1], "-d")) {
+			differential = true;
+			argv++;
+			argc--;
 		} else
 			return CMD_RET_USAGE;
 	}
@@ -3450,7 +3604,7 @@ static int do_fsimage_save(struct cmd_tbl *cmdtp, int flag, int argc,
 
 	/* If this is an U-Boot image, handle separately */
 	if (fs_image_match((void *)addr, "U-BOOT", NULL))
-		return do_fsimage_save_uboot(addr, force);
+		return do_fsimage_save_uboot(addr, force, differential);
 
 	/* Handle NBoot image */
 	ret = fs_image_find_board_cfg(addr, force, "save",
@@ -3475,6 +3629,7 @@ static int do_fsimage_save(struct cmd_tbl *cmdtp, int flag, int argc,
 	if (fs_image_get_flash_info(&fi, fdt)
 	    || fs_image_get_nboot_info(&fi, fdt, &ni, boot_hwpart, false))
 		return CMD_RET_FAILURE;
+	fi.differential = differential;
 
 	ret = fs_image_check_boot_dev_fuses(fi.boot_dev, "save");
 	if (ret < 0)
@@ -3685,6 +3840,7 @@ static int do_fsimage_save(struct cmd_tbl *cmdtp, int flag, int argc,
 			failed = nboot_failed;
 	}
 
+	fs_image_show_diff_stats(&fi);
 	fs_image_put_flash_info(&fi);
 
 	ret = fs_image_show_save_status(failed, "NBoot");
@@ -3923,6 +4079,24 @@ static int do_fsimage_checksum(struct cmd_tbl *cmdtp, int flag, int argc,
 
 		pcs = (u32 *)&sub_fsh->type[12];
 		printf("Checksum[%s] = 0x%x\n",sub_fsh->type,*pcs);
+
+#ifdef CONFIG_FS_IMAGE_SHA256
+		if (sub_fsh->info.flags & FSH_FLAGS_SHA256) {
+			u8 *digest = (u8 *)(sub_fsh + 1);
+			int i;
+
+			if (fs_image_check_sha256(sub_fsh) < 0) {
+				printf("SHA-256 of %s invalid!\n", type);
+				return CMD_RET_FAILURE;
+			}
+			digest += fs_image_get_size(sub_fsh, false);
+			digest -= FSH_SHA256_SIZE;
+			printf("SHA-256[%s] = ", sub_fsh->type);
+			for (i = 0; i < FSH_SHA256_SIZE; i++)
+				printf("%02x", digest[i]);
+			puts("\n");
+		}
+#endif
 	}
 	else {
 		printf("Checksums of F&S image at addr 0x%lx\n\n", addr);
@@ -3946,7 +4120,7 @@ static struct cmd_tbl cmd_fsimage_sub[] = {
 	U_BOOT_CMD_MKENT(boot, 1, 1, do_fsimage_boot, "", ""),
 	U_BOOT_CMD_MKENT(list, 1, 1, do_fsimage_list, "", ""),
 	U_BOOT_CMD_MKENT(load, 2, 1, do_fsimage_load, "", ""),
-	U_BOOT_CMD_MKENT(save, 4, 0, do_fsimage_save, "", ""),
+	U_BOOT_CMD_MKENT(save, 5, 0, do_fsimage_save, "", ""),
 	U_BOOT_CMD_MKENT(fuse, 2, 0, do_fsimage_fuse, "", ""),
 	U_BOOT_CMD_MKENT(checksum, 3, 1, do_fsimage_checksum, "", ""),
 };
@@ -4001,7 +4175,7 @@ static int do_fsimage(struct cmd_tbl *cmdtp, int flag, int argc,
 	return cp->cmd(cmdtp, flag, argc, argv);
 }
 
-U_BOOT_CMD(fsimage, 5, 1, do_fsimage,
+U_BOOT_CMD(fsimage, 6, 1, do_fsimage,
 	   "Handle F&S board configuration and F&S images, e.g. U-Boot, NBOOT",
 	   "arch\n"
 	   "    - Show F&S architecture\n"
@@ -4017,7 +4191,7 @@ U_BOOT_CMD(fsimage, 5, 1, do_fsimage,
 	   "    - List the content of the F&S image at <addr>\n"
 	   "fsimage load [-f] [uboot | nboot] [<addr>]\n"
 	   "    - Verify the current NBoot or U-Boot and load to <addr>\n"
-	   "fsimage save [-f] [-e <n>] [-b <n>] [<addr>]\n"
+	   "fsimage save [-f] [-d] [-e <n>] [-b <n>] [<addr>]\n"
 	   "    - Save the F&S image at the right place (NBoot, U-Boot)\n"
 	   "fsimage fuse [-f] [<addr> | stored]\n"
 	   "    - Program fuses according to the current BOARD-CFG.\n"
@@ -4030,9 +4204,11 @@ U_BOOT_CMD(fsimage, 5, 1, do_fsimage,
 	   "continue without showing any confirmation queries. This is meant\n"
 	   "for non-interactive installation procedures. Option -b also sets\n"
 	   "the eMMC hwpart to boot from: 0: User, 1: Boot1, 2: Boot2. This\n"
-	   "option is ignored on NAND. Option -e supports handling early\n"
-	   "NBoot versions. If the environment is not found when updating\n"
-	   "from a pre 2023.08 NBoot version, try increasing <n> until it\n"
-	   "works. Be careful when storing such an old NBoot, you need to\n"
-	   "know the right <n> or you will lose the environment.\n"
+	   "option is ignored on NAND. Option -d compares with the data\n"
+	   "in flash first and skips everything that is unchanged. Option\n"
+	   "-e supports handling early NBoot versions. If the environment\n"
+	   "is not found when updating from a pre 2023.08 NBoot version,\n"
+	   "try increasing <n> until it works. Be careful when storing such\n"
+	   "an old NBoot, you need to know the right <n> or you will lose\n"
+	   "the environment.\n"
 );
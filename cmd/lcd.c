@@ -132,6 +132,8 @@
 #include <serial.h>			  /* serial_putc(), serial_puts() */
 #include <linux/ctype.h>		  /* isdigit() */
 #include <video_font.h>			  /* Get font data, width and height */
+#include <cpu_func.h>			  /* flush_dcache_range() */
+#include <asm/cache.h>			  /* ARCH_DMA_MINALIGN */
 
 #if defined(CONFIG_S3C64XX)
 #include <s3c64xx_xlcd.h>		  /* s3c64xx_xlcd_init() */
@@ -210,6 +212,8 @@ enum LCD_INDEX {
 	LI_LIST,
 	LI_ON,
 	LI_OFF,
+	LI_BATCH,
+	LI_SYNC,
 #if (CONFIG_XLCD_DISPLAYS > 1)
 	LI_ALL,
 #endif
@@ -270,6 +274,12 @@ static vidinfo_t vidinfo[CONFIG_XLCD_DISPLAYS]; /* Current display info */
 
 static u_long fbused;			  /* Used part of frambuffer pool */
 
+static u_int batch_level;		  /* >0: defer D-cache flushing */
+
+/* Maximum nesting of "lcd batch"; a script that never calls "lcd sync" must
+   not keep the flushing disabled forever */
+#define LCD_BATCH_MAX 8
+
 #ifndef CONFIG_XLCD_CONSOLE_MULTI
 coninfo_t coninfo;			  /* Console information */
 wininfo_t *console_pwi;			  /* Pointer to window with console */
@@ -326,6 +336,8 @@ static kwinfo_t const lcd_kw[] = {
 						      [count]]*/
 	[LI_ON] =	 {0, 0, 0, 0, "on"},	   /* (no args) */
 	[LI_OFF] =	 {0, 0, 0, 0, "off"},	   /* (no args) */
+	[LI_BATCH] =	 {0, 0, 0, 0, "batch"},	   /* (no args) */
+	[LI_SYNC] =	 {0, 0, 0, 0, "sync"},	   /* (no args) */
 #if (CONFIG_XLCD_DISPLAYS > 1)
 	[LI_ALL] =	 {0, 0, 0, 0, "all"},	   /* (no args) */
 #endif
@@ -617,6 +629,155 @@ U_BOOT_CMD(
 #endif //0 #####
 
 
+/************************************************************************/
+/* DAMAGE TRACKING							*/
+/************************************************************************/
+
+/* Mark region of the draw buffer as modified. If the region touches or
+   overlaps a region that is already recorded, both are merged. If all
+   entries are in use, the region is merged with the entry that grows least.
+   The damage info is pure bookkeeping, so we also allow it for const
+   windows. */
+void lcd_damage(const wininfo_t *pwi, XYPOS x1, XYPOS y1, XYPOS x2, XYPOS y2)
+{
+	wininfo_t *p = (wininfo_t *)pwi;
+	dmrect_t *pdr;
+	dmrect_t *best = NULL;
+	u_long best_grow = ~0UL;
+	u_int i;
+
+	/* Clip to framebuffer, ignore empty regions */
+	if (x1 < 0)
+		x1 = 0;
+	if (y1 < 0)
+		y1 = 0;
+	if (x2 >= pwi->fbhres)
+		x2 = pwi->fbhres - 1;
+	if (y2 >= pwi->fbvres)
+		y2 = pwi->fbvres - 1;
+	if ((x1 > x2) || (y1 > y2))
+		return;
+
+	for (i = 0; i < p->damage_count; i++) {
+		pdr = &p->damage[i];
+		if ((x1 <= pdr->x2 + 1) && (x2 + 1 >= pdr->x1)
+		    && (y1 <= pdr->y2 + 1) && (y2 + 1 >= pdr->y1)) {
+			best = pdr;
+			break;
+		}
+	}
+
+	if (!best) {
+		if (p->damage_count < DAMAGE_RECTS) {
+			pdr = &p->damage[p->damage_count++];
+			pdr->x1 = x1;
+			pdr->y1 = y1;
+			pdr->x2 = x2;
+			pdr->y2 = y2;
+			return;
+		}
+		for (i = 0; i < DAMAGE_RECTS; i++) {
+			u_long grow;
+
+			pdr = &p->damage[i];
+			grow = (u_long)(max(x2, pdr->x2) - min(x1, pdr->x1) + 1)
+				* (max(y2, pdr->y2) - min(y1, pdr->y1) + 1)
+				- (u_long)(pdr->x2 - pdr->x1 + 1)
+				* (pdr->y2 - pdr->y1 + 1);
+			if (grow < best_grow) {
+				best_grow = grow;
+				best = pdr;
+			}
+		}
+	}
+
+	if (x1 < best->x1)
+		best->x1 = x1;
+	if (y1 < best->y1)
+		best->y1 = y1;
+	if (x2 > best->x2)
+		best->x2 = x2;
+	if (y2 > best->y2)
+		best->y2 = y2;
+}
+
+/* Flush framebuffer range from D-cache; round to full cache lines */
+static void lcd_flush_range(u_long start, u_long end)
+{
+	start &= ~(ARCH_DMA_MINALIGN - 1);
+	end = (end + ARCH_DMA_MINALIGN - 1) & ~(ARCH_DMA_MINALIGN - 1);
+	flush_dcache_range(start, end);
+}
+
+/* Flush all modified regions of the window from D-cache */
+void lcd_flush_damage(const wininfo_t *pwi)
+{
+	wininfo_t *p = (wininfo_t *)pwi;
+	u_long fbuf = pwi->pfbuf[pwi->fbdraw];
+	u_long linelen = pwi->linelen;
+	u_int bpp_shift = pwi->ppi->bpp_shift;
+	u_int i;
+
+	for (i = 0; i < p->damage_count; i++) {
+		const dmrect_t *pdr = &p->damage[i];
+		u_long line = fbuf + pdr->y1 * linelen;
+		u_long left, right;
+		XYPOS y;
+
+		/* If the region covers a large part of the lines, flush all
+		   lines in one go, which is faster than many small flushes */
+		if (2 * (pdr->x2 - pdr->x1 + 1) >= pwi->fbhres) {
+			lcd_flush_range(line, line + (pdr->y2 - pdr->y1 + 1)
+					* linelen);
+			continue;
+		}
+
+		left = (pdr->x1 << bpp_shift) >> 3;
+		right = (((pdr->x2 + 1) << bpp_shift) + 7) >> 3;
+		for (y = pdr->y1; y <= pdr->y2; y++) {
+			lcd_flush_range(line + left, line + right);
+			line += linelen;
+		}
+	}
+	p->damage_count = 0;
+}
+
+/* Start a batch of drawing operations; batches may be nested */
+void lcd_batch_begin(void)
+{
+	batch_level++;
+}
+
+/* End a batch of drawing operations; if this was the outermost batch (or if
+   there was no batch at all), flush all modified regions of all windows */
+void lcd_batch_end(void)
+{
+	VID vid;
+	WINDOW win;
+
+	if (batch_level && --batch_level)
+		return;
+
+	for (vid = 0; vid < vid_count; vid++) {
+		const vidinfo_t *pvi = lcd_get_vidinfo_p(vid);
+
+		for (win = 0; win < pvi->wincount; win++) {
+			const wininfo_t *pwi = lcd_get_wininfo_p(pvi, win);
+
+			if (pwi->damage_count)
+				lcd_flush_damage(pwi);
+		}
+	}
+}
+
+/* End all open batches and flush all modified regions */
+static void lcd_batch_reset(void)
+{
+	batch_level = 0;
+	lcd_batch_end();
+}
+
+
 /************************************************************************/
 /* CONSOLE SUPPORT							*/
 /************************************************************************/
@@ -646,8 +807,11 @@ void console_update(wininfo_t *pwi, RGBA fg, RGBA bg)
 /* Clear the console window with given color */
 void console_cls(const wininfo_t *pwi, COLOR32 col)
 {
+	lcd_batch_begin();
 	memset32((unsigned *)pwi->pfbuf[pwi->fbdraw], col2col32(pwi, col),
 		 pwi->fbsize/4);
+	lcd_damage(pwi, 0, 0, pwi->fbhres - 1, pwi->fbvres - 1);
+	lcd_batch_end();
 }
 
 
@@ -707,6 +871,7 @@ static void console_putc(wininfo_t *pwi, coninfo_t *pci, char c)
 			   background color */
 			memset32((unsigned *)(fbuf + y*linelen), bg,
 				 (fbvres - y)*linelen/4);
+			lcd_damage(pwi, 0, 0, fbhres - 1, fbvres - 1);
 		}
 		/* Fall through to case '\r' */
 
@@ -728,9 +893,11 @@ void lcd_putc(const struct stdio_dev *pdev, const char c)
 	wininfo_t *pwi = (wininfo_t *)pdev->priv;
 	vidinfo_t *pvi = pwi->pvi;
 
-	if (pvi->is_enabled && pwi->active)
+	if (pvi->is_enabled && pwi->active) {
+		lcd_batch_begin();
 		console_putc(pwi, &pwi->ci, c);
-	else
+		lcd_batch_end();
+	} else
 		serial_putc(NULL, c);
 }
 #else
@@ -739,9 +906,11 @@ void lcd_putc(const struct stdio_dev *pdev, const char c)
 	wininfo_t *pwi = console_pwi;
 	vidinfo_t *pvi = pwi->pvi;
 
-	if (pvi->is_enabled && pwi->active)
+	if (pvi->is_enabled && pwi->active) {
+		lcd_batch_begin();
 		console_putc(pwi, &coninfo, c);
-	else
+		lcd_batch_end();
+	} else
 		serial_putc(NULL, c);
 }
 #endif /*CONFIG_XLCD_CONSOLE_MULTI*/
@@ -756,6 +925,7 @@ void lcd_puts(const struct stdio_dev *pdev, const char *s)
 
 	if (pvi->is_enabled && pwi->active) {
 		coninfo_t *pci = &pwi->ci;
+		lcd_batch_begin();
 		for (;;)
 		{
 			char c = *s++;
@@ -764,6 +934,7 @@ void lcd_puts(const struct stdio_dev *pdev, const char *s)
 				break;
 			console_putc(pwi, pci, c);
 		}
+		lcd_batch_end();
 	} else
 		serial_puts(NULL, s);
 }
@@ -775,6 +946,7 @@ void lcd_puts(const struct stdio_dev *pdev, const char *s)
 
 	if (pvi->is_enabled && pwi->active) {
 		coninfo_t *pci = &coninfo;
+		lcd_batch_begin();
 		for (;;)
 		{
 			char c = *s++;
@@ -783,6 +955,7 @@ void lcd_puts(const struct stdio_dev *pdev, const char *s)
 				break;
 			console_putc(pwi, pci, c);
 		}
+		lcd_batch_end();
 	} else
 		serial_puts(NULL, s);
 }
@@ -1114,6 +1287,7 @@ static int do_lcd(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 	switch (sc) {
 	case LI_ON: {
 		char *errmsg;
+		lcd_batch_reset();
 		errmsg = lcd_on(pvi);
 		if (errmsg)
 			puts(errmsg);
@@ -1121,9 +1295,23 @@ static int do_lcd(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 	}
 
 	case LI_OFF:
+		lcd_batch_reset();
 		lcd_off(pvi);
 		return 0;
 
+	case LI_BATCH:
+		if (batch_level >= LCD_BATCH_MAX) {
+			printf("Too many nested batches, max. %u\n",
+			       LCD_BATCH_MAX);
+			return 1;
+		}
+		lcd_batch_begin();
+		return 0;
+
+	case LI_SYNC:
+		lcd_batch_end();
+		return 0;
+
 	case LI_LIST: {
 		unsigned count = 0xFFFFFFFF;
 		unsigned index = 0;
@@ -1359,6 +1547,9 @@ U_BOOT_CMD(
 	"\tdim, res, htiming, vtiming, pol, pwm, ponseq, poffseq, extra\n"
 	"lcd on | off\n"
 	"    - activate or deactivate lcd\n"
+	"lcd batch | sync\n"
+	"    - defer framebuffer cache flushing | flush modified regions\n"
+	"      (batches nest up to 8 levels, lcd on/off ends all batches)\n"
 #if (CONFIG_XLCD_DISPLAYS > 1)
 	"lcd all\n"
 	"    - list information of all displays\n"
@@ -1460,6 +1651,7 @@ int setfbuf(wininfo_t *pwi, XYPOS hres, XYPOS vres,
 	pwi->linelen = linelen;
 	pwi->fbsize = fbsize;
 	pwi->fbdraw = 0;
+	pwi->damage_count = 0;
 	pwi->fbshow = 0;
 	if (pwi->pix != pix) {
 		/* New pixel format: set default bg + fg */
@@ -1809,6 +2001,7 @@ void drv_lcd_init(void)
 			pwi->linelen = 0;
 			pwi->fbcount = 0;
 			pwi->fbdraw = 0;
+			pwi->damage_count = 0;
 			pwi->fbshow = 0;
 			pwi->fbhres = 0;
 			pwi->fbvres = 0;
@@ -54,6 +54,13 @@ static void print_mmcinfo(struct mmc *mmc)
 	puts("Erase Group Size: ");
 	print_size(((u64)mmc->erase_grp_size) << 9, "\n");
 #endif
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+	if (mmc->cache_size) {
+		puts("Cache Size: ");
+		print_size(((u64)mmc->cache_size) << 10,
+			   mmc->cache_on ? " ON\n" : " OFF\n");
+	}
+#endif
 
 	if (!IS_SD(mmc) && mmc->version >= MMC_VERSION_4_41) {
 		bool has_enh = (mmc->part_support & ENHNCD_SUPPORT) != 0;
@@ -932,6 +939,53 @@ static int do_mmc_bkops_enable(struct cmd_tbl *cmdtp, int flag,
 }
 #endif
 
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+static int do_mmc_cache(struct cmd_tbl *cmdtp, int flag,
+			int argc, char *const argv[])
+{
+	struct mmc *mmc;
+	int err;
+
+	mmc = init_mmc_device(curr_device, false);
+	if (!mmc)
+		return CMD_RET_FAILURE;
+	if (IS_SD(mmc) || !mmc->cache_size) {
+		puts("Device has no cache\n");
+		return CMD_RET_FAILURE;
+	}
+
+	if (argc == 2) {
+		if (!strcmp(argv[1], "on"))
+			err = mmc_cache_ctrl(mmc, true);
+		else if (!strcmp(argv[1], "off"))
+			err = mmc_cache_ctrl(mmc, false);
+		else
+			return CMD_RET_USAGE;
+		if (err)
+			return CMD_RET_FAILURE;
+	}
+	printf("Cache is %s\n", mmc->cache_on ? "on" : "off");
+
+	return CMD_RET_SUCCESS;
+}
+
+static int do_mmc_flush(struct cmd_tbl *cmdtp, int flag,
+			int argc, char *const argv[])
+{
+	struct mmc *mmc;
+
+	mmc = find_mmc_device(curr_device);
+	if (!mmc) {
+		printf("no mmc device at slot %x\n", curr_device);
+		return CMD_RET_FAILURE;
+	}
+	if (!mmc->has_init)
+		return CMD_RET_SUCCESS;
+
+	return mmc_flush_cache(mmc) ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+#endif
+
 static int do_mmc_boot_wp(struct cmd_tbl *cmdtp, int flag,
 			  int argc, char * const argv[])
 {
@@ -960,6 +1014,10 @@ static struct cmd_tbl cmd_mmc[] = {
 	U_BOOT_CMD_MKENT(write, 4, 0, do_mmc_write, "", ""),
 	U_BOOT_CMD_MKENT(erase, 3, 0, do_mmc_erase, "", ""),
 #endif
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+	U_BOOT_CMD_MKENT(cache, 2, 0, do_mmc_cache, "", ""),
+	U_BOOT_CMD_MKENT(flush, 1, 0, do_mmc_flush, "", ""),
+#endif
 #if CONFIG_IS_ENABLED(CMD_MMC_SWRITE)
 	U_BOOT_CMD_MKENT(swrite, 3, 0, do_mmc_sparse_write, "", ""),
 #endif
@@ -1022,6 +1080,10 @@ U_BOOT_CMD(
 	"mmc swrite addr blk#\n"
 #endif
 	"mmc erase blk# cnt\n"
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+	"mmc cache [on|off] - show or set eMMC volatile cache state\n"
+	"mmc flush - write eMMC volatile cache to the medium\n"
+#endif
 	"mmc rescan\n"
 	"mmc part - lists available partition on current mmc device\n"
 	"mmc dev [dev] [part] - show or set current mmc device [partition]\n"
@@ -794,6 +794,19 @@ static int do_nand(struct cmd_tbl *cmdtp, int flag, int argc,
 	}
 #endif
 
+#ifdef CONFIG_NAND_REFRESH
+	if (strcmp(cmd, "refresh") == 0) {
+		if (argc > 2) {
+			if (strcmp(argv[2], "stats"))
+				goto usage;
+			nand_refresh_show_stats(mtd);
+			return 0;
+		}
+		nand_refresh_run_queue(mtd);
+		return 0;
+	}
+#endif
+
 	if (strcmp(cmd, "markbad") == 0) {
 		argc -= 2;
 		argv += 2;
@@ -925,6 +938,10 @@ static char nand_help_text[] =
 	"nand scrub [-y] off size | scrub.part partition | scrub.chip\n"
 	"    really clean NAND erasing bad blocks (UNSAFE)\n"
 	"nand markbad off [...] - mark bad block(s) at offset (UNSAFE)\n"
+#ifdef CONFIG_NAND_REFRESH
+	"nand refresh - refresh all blocks queued because of many bitflips\n"
+	"nand refresh stats - show bitflip statistics and refresh queue\n"
+#endif
 #if 0
 	"nand biterr off - make a bit error at offset (UNSAFE)"
 #endif
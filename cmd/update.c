@@ -246,6 +246,46 @@ static int update_mmc(const char *action, const char **check, const char *fname,
 
 	return 0;
 }
+
+/*
+ * Start the initialization of the MMC devices in the check list that are not
+ * checked first. This is not done in the background. For an eMMC, only CMD1
+ * is sent and mmc_init() in update_mmc() polls for the end of the power up
+ * later, so the other devices are checked in the meantime. For an SD card,
+ * mmc_start_init() itself waits for ACMD41, which may take up to 1 s.
+ *
+ * A device at the start of the list, or only preceded by ram, is checked
+ * right away anyway, so nothing is gained by starting it here.
+ */
+static void update_mmc_start_init(const char *check)
+{
+	char if_dev_part_str[MAX_IF_DEV_PART_STR + 1];
+	struct mmc *mmc;
+	int first = 1;
+
+	do {
+		/* Skip any commas and whitespace */
+		while ((*check == ',') || (*check == ' ') || (*check == '\t'))
+			check++;
+
+		if (strncmp(check, "ram", 3) == 0) {
+			/* Loading from RAM takes no time */
+		} else if (first) {
+			first = 0;
+		} else if (strncmp(check, "mmc", 3) == 0
+			   && !get_if_dev_part_str(if_dev_part_str, &check)) {
+			mmc = find_mmc_device(simple_strtoul(if_dev_part_str + 4,
+							     NULL, 0));
+			if (mmc && !mmc->has_init && !mmc->init_in_progress
+			    && mmc_getcd(mmc))
+				mmc_start_init(mmc);
+		}
+
+		/* Go to next device */
+		while (*check && (*check != ','))
+			check++;
+	} while (*check);
+}
 #endif /* CONFIG_MMC */
 
 #ifdef CONFIG_USB_STORAGE
@@ -380,6 +420,11 @@ int update_script(enum update_action action_id, const char *check,
 		}
 	}
 
+#if defined(CONFIG_MMC) && defined(CONFIG_FS_FAT)
+	/* Let later MMC devices power up while the first ones are checked */
+	update_mmc_start_init(check);
+#endif
+
 	/* Parse devices and check for script */
 	do {
 		/* Skip any commas and whitespace */
@@ -13,6 +13,7 @@
 #include <errno.h>
 #include <g_dnl.h>
 #include <malloc.h>
+#include <mmc.h>
 #include <part.h>
 #include <usb.h>
 #include <usb_mass_storage.h>
@@ -44,6 +45,9 @@ static void ums_fini(void)
 {
 	int i;
 
+	/* The host is done, make sure that everything it wrote is stored */
+	mmc_flush_caches();
+
 	for (i = 0; i < ums_count; i++)
 		free((void *)ums[i].name);
 	free(ums);
@@ -338,6 +338,10 @@ static int do_win(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 			return 1;
 		}
 
+		/* Make sure that all drawing reached the framebuffer before
+		   showing it or switching to another draw buffer */
+		lcd_flush_damage(pwi);
+
 		/* Argument 2: buffer number to draw to */
 		if (argc > 3) {
 			u_char fbdraw;
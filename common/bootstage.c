@@ -359,6 +359,22 @@ void bootstage_report(void)
 	}
 }
 
+const char *bootstage_get_record(uint index, char *buf, int len,
+				 ulong *time_usp, bool *accump)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_record *rec;
+
+	if (!data || index >= data->rec_count)
+		return NULL;
+
+	rec = &data->record[index];
+	*time_usp = rec->time_us;
+	*accump = rec->start_us != 0;
+
+	return get_record_name(buf, len, rec);
+}
+
 /**
  * Append data to a memory buffer
  *
@@ -38,6 +38,8 @@ void adraw_ll_pixel(const wininfo_t *pwi, XYPOS x, XYPOS y,
 	u_int shift = 32 - (xpos & 31) - bpp;
 	COLOR32 col;
 
+	lcd_damage(pwi, x, y, x, y);
+
 	/* Compute framebuffer address of the pixel */
 	fbuf = pwi->linelen * y + pwi->pfbuf[pwi->fbdraw];
 
@@ -68,6 +70,8 @@ void adraw_ll_rect(const wininfo_t *pwi, XYPOS x1, XYPOS y1,
 	int ycount, xcount;
 	int xpos;
 
+	lcd_damage(pwi, x1, y1, x2, y2);
+
 	xcount = x2 - x1 + 1;
 	ycount = y2 - y1 + 1;
 	xpos = x1 << bpp_shift;
@@ -120,6 +124,10 @@ void adraw_ll_char(const wininfo_t *pwi, XYPOS x, XYPOS y, char c,
 	const VIDEO_FONT_TYPE *pfont;
 	COLOR32 mask = (1 << bpp) - 1;	  /* This also works for bpp==32! */
 	u_int shift = 32 - (xpos & 31);
+	XYPOS width = VIDEO_FONT_WIDTH * (((attr & ATTR_HS_MASK) >> 4) + 1);
+	XYPOS height = VIDEO_FONT_HEIGHT * (((attr & ATTR_VS_MASK) >> 6) + 1);
+
+	lcd_damage(pwi, x, y, x + width - 1, y + height - 1);
 
 	/* Compute framebuffer address of the pixel */
 	fbuf = linelen * y + ((xpos >> 5) << 2) + pwi->pfbuf[pwi->fbdraw];
@@ -207,7 +215,8 @@ void adraw_ll_char(const wininfo_t *pwi, XYPOS x, XYPOS y, char c,
 /* DRAWING BITMAP ROWS							*/
 /************************************************************************/
 
-#if defined(CONFIG_XLCD_PNG) || defined(CONFIG_XLCD_BMP)
+#if defined(CONFIG_XLCD_PNG) || defined(CONFIG_XLCD_BMP) \
+	|| defined(CONFIG_XLCD_JPG)
 /* Normal version for 1bpp, 2bpp, 4bpp */
 void adraw_ll_row_PAL(imginfo_t *pii, COLOR32 *p)
 {
@@ -308,7 +317,7 @@ void adraw_ll_row_PAL8(imginfo_t *pii, COLOR32 *p)
 DONE:
 	*p = val;			  /* Store final value */
 }
-#endif /* CONFIG_XLCD_PNG || CONFIG_XLCD_BMP */
+#endif /* CONFIG_XLCD_PNG || CONFIG_XLCD_BMP || CONFIG_XLCD_JPG */
 
 
 #ifdef CONFIG_XLCD_PNG
@@ -354,8 +363,10 @@ void adraw_ll_row_GA(imginfo_t *pii, COLOR32 *p)
 DONE:
 	*p = val;			  /* Store final value */
 }
+#endif /* CONFIG_XLCD_PNG */
 
 
+#if defined(CONFIG_XLCD_PNG) || defined(CONFIG_XLCD_JPG)
 void adraw_ll_row_RGB(imginfo_t *pii, COLOR32 *p)
 {
 	int xpix = pii->xpix;
@@ -395,8 +406,10 @@ void adraw_ll_row_RGB(imginfo_t *pii, COLOR32 *p)
 DONE:
 	*p = val;			  /* Store final value */
 }
+#endif /* CONFIG_XLCD_PNG || CONFIG_XLCD_JPG */
 
 
+#ifdef CONFIG_XLCD_PNG
 void adraw_ll_row_RGBA(imginfo_t *pii, COLOR32 *p)
 {
 	int xpix = pii->xpix;
@@ -34,6 +34,8 @@ void draw_ll_pixel(const wininfo_t *pwi, XYPOS x, XYPOS y, COLOR32 col)
 	COLOR32 *p;
 	u_int shift = 32 - (xpos & 31) - bpp;
 
+	lcd_damage(pwi, x, y, x, y);
+
 	/* Compute framebuffer address of the pixel */
 	fbuf = pwi->linelen * y + pwi->pfbuf[pwi->fbdraw];
 
@@ -60,6 +62,8 @@ void draw_ll_rect(const wininfo_t *pwi, XYPOS x1, XYPOS y1,
 	int count;
 	int xpos;
 
+	lcd_damage(pwi, x1, y1, x2, y2);
+
 	/* Repeat color so that it fills the whole 32 bits */
 	color = col2col32(pwi, color);
 
@@ -114,7 +118,32 @@ void draw_ll_rect(const wininfo_t *pwi, XYPOS x1, XYPOS y1,
 /* DRAWING BITMAP ROWS							*/
 /************************************************************************/
 
-#if defined(CONFIG_XLCD_PNG) || defined(CONFIG_XLCD_BMP)
+/* All row functions have two versions: if the framebuffer has 32bpp and the
+   bitmap is not stretched horizontally, each pixel is exactly one word and
+   we can store the whole row in one pass without any masking. Otherwise we
+   have to merge the pixels into the framebuffer words one by one. */
+
+/* Return true if each bitmap pixel can be stored as a whole word */
+static inline int row_is_direct(const imginfo_t *pii)
+{
+	return (pii->bpp == 32) && (pii->multiwidth == 1);
+}
+
+/* Convert RGBA value to framebuffer color. Bitmap rows often contain long
+   runs of the same color, so remember the last conversion and only call
+   rgba2col() if the color changes. */
+static inline COLOR32 row_rgba2col(imginfo_t *pii, RGBA rgba)
+{
+	if (rgba != pii->hash_rgba) {
+		pii->hash_rgba = rgba;
+		pii->hash_col = pii->pwi->ppi->rgba2col(pii->pwi, rgba);
+	}
+
+	return pii->hash_col;
+}
+
+#if defined(CONFIG_XLCD_PNG) || defined(CONFIG_XLCD_BMP) \
+	|| defined(CONFIG_XLCD_JPG)
 /* Version for 1bpp, 2bpp and 4bpp */
 void draw_ll_row_PAL(imginfo_t *pii, COLOR32 *p)
 {
@@ -126,17 +155,30 @@ void draw_ll_row_PAL(imginfo_t *pii, COLOR32 *p)
 
 	u_char *prow = pii->prow;
 	u_int rowshift = pii->rowshift;
-	//u_int rowbitdepth = pii->rowbitdepth;
-	//u_int rowmask = pii->rowmask;
+	u_int rowbitdepth = pii->rowbitdepth;
+	u_int rowmask = pii->rowmask;
 	COLOR32 mask = pii->mask;
-	//u_int multiwidth = pii->multiwidth;
+	u_int multiwidth = pii->multiwidth;
+	u_int count = multiwidth - xpix % multiwidth;
+
+	if (row_is_direct(pii)) {
+		for (; xpix < xend; xpix++) {
+			rowshift -= rowbitdepth;
+			*p++ = pii->palette[(*prow >> rowshift) & rowmask];
+			if (!rowshift) {
+				prow++;
+				rowshift = 8;
+			}
+		}
+		return;
+	}
 
 	val = *p;
 	for (;;) {
 		COLOR32 col;
 
-		rowshift -= pii->rowbitdepth;
-		col = pii->palette[(*prow >> rowshift) & pii->rowmask];
+		rowshift -= rowbitdepth;
+		col = pii->palette[(*prow >> rowshift) & rowmask];
 		if (!rowshift) {
 			prow++;
 			rowshift = 8;
@@ -145,14 +187,15 @@ void draw_ll_row_PAL(imginfo_t *pii, COLOR32 *p)
 			shift -= bpp;
 			val &= ~(mask << shift);
 			val |= col << shift;
-			if (++xpix >= /*pii->*/xend)
+			if (++xpix >= xend)
 				goto DONE;
 			if (!shift) {
 				*p++ = val;
 				val = *p;
 				shift = 32;
 			}
-		} while (xpix % pii->multiwidth);
+		} while (--count);
+		count = multiwidth;
 	}
 DONE:
 	*p = val; /* Store final value */
@@ -167,10 +210,20 @@ void draw_ll_row_PAL8(imginfo_t *pii, COLOR32 *p)
 	u_int shift = pii->shift;
 	u_int bpp = pii->bpp;
 	u_char *prow = pii->prow;
-	COLOR32 val = *p;
+	COLOR32 val;
 	COLOR32 mask = pii->mask;
 	u_int multiwidth = pii->multiwidth;
+	u_int count = multiwidth - xpix % multiwidth;
+
+	if (row_is_direct(pii)) {
+		const RGBA *palette = pii->palette;
+
+		for (; xpix < xend; xpix++)
+			*p++ = (COLOR32)palette[*prow++];
+		return;
+	}
 
+	val = *p;
 	for (;;) {
 		COLOR32 col;
 
@@ -187,25 +240,41 @@ void draw_ll_row_PAL8(imginfo_t *pii, COLOR32 *p)
 				val = *p;
 				shift = 32;
 			}
-		} while (xpix % multiwidth);
+		} while (--count);
+		count = multiwidth;
 		prow++;
 	}
 DONE:
 	*p = val; /* Store final value */
 }
-#endif /* CONFIG_XLCD_PNG || CONFIG_XLCD_BMP */
+#endif /* CONFIG_XLCD_PNG || CONFIG_XLCD_BMP || CONFIG_XLCD_JPG */
 
 
 #ifdef CONFIG_XLCD_PNG
 void draw_ll_row_GA(imginfo_t *pii, COLOR32 *p)
-
 {
 	int xpix = pii->xpix;
+	int xend = pii->xend;
 	u_int shift = pii->shift;
+	u_int bpp = pii->bpp;
 	COLOR32 val;
-	const wininfo_t *pwi = pii->pwi;
+	COLOR32 mask = pii->mask;
+	u_int multiwidth = pii->multiwidth;
+	u_int count = multiwidth - xpix % multiwidth;
 	u_char *prow = pii->prow;
 
+	if (row_is_direct(pii)) {
+		for (; xpix < xend; xpix++) {
+			RGBA rgba;
+
+			rgba = prow[0] * 0x01010100;	/* R, G, B[7:0] */
+			rgba |= prow[1];		/* A[7:0] */
+			*p++ = row_rgba2col(pii, rgba);
+			prow += 2;
+		}
+		return;
+	}
+
 	val = *p;
 	for (;;) {
 		RGBA rgba;
@@ -214,35 +283,58 @@ void draw_ll_row_GA(imginfo_t *pii, COLOR32 *p)
 		rgba = prow[0] << 8;	            /* B[7:0] */
 		rgba |= (rgba << 8) | (rgba << 16); /* G[7:0], R[7:0] */
 		rgba |= prow[1];		    /* A[7:0] */
-		col = pwi->ppi->rgba2col(pwi, rgba);
+		col = row_rgba2col(pii, rgba);
 		do {
-			shift -= pii->bpp;
-			val &= ~(pii->mask << shift);
+			shift -= bpp;
+			val &= ~(mask << shift);
 			val |= col << shift;
-			if (++xpix >= pii->xend)
+			if (++xpix >= xend)
 				goto DONE;
 			if (!shift) {
 				*p++ = val;
 				val = *p;
 				shift = 32;
 			}
-		} while (xpix % pii->multiwidth);
+		} while (--count);
+		count = multiwidth;
 		prow += 2;
 	}
 DONE:
 	*p = val; /* Store final value */
 
 }
+#endif /* CONFIG_XLCD_PNG */
 
 
+#if defined(CONFIG_XLCD_PNG) || defined(CONFIG_XLCD_JPG)
 void draw_ll_row_RGB(imginfo_t *pii, COLOR32 *p)
 {
 	int xpix = pii->xpix;
+	int xend = pii->xend;
 	u_int shift = pii->shift;
+	u_int bpp = pii->bpp;
 	COLOR32 val;
-	const wininfo_t *pwi = pii->pwi;
+	COLOR32 mask = pii->mask;
+	u_int multiwidth = pii->multiwidth;
+	u_int count = multiwidth - xpix % multiwidth;
+	RGBA trans_rgba = pii->trans_rgba;
 	u_char *prow = pii->prow;
 
+	if (row_is_direct(pii)) {
+		for (; xpix < xend; xpix++) {
+			RGBA rgba;
+
+			rgba = prow[0] << 24;
+			rgba |= prow[1] << 16;
+			rgba |= prow[2] << 8;
+			if (rgba != trans_rgba)
+				rgba |= 0xFF;
+			*p++ = row_rgba2col(pii, rgba);
+			prow += 3;
+		}
+		return;
+	}
+
 	val = *p;
 	for (;;) {
 		RGBA rgba;
@@ -251,36 +343,57 @@ void draw_ll_row_RGB(imginfo_t *pii, COLOR32 *p)
 		rgba = prow[0] << 24;
 		rgba |= prow[1] << 16;
 		rgba |= prow[2] << 8;
-		if (rgba != pii->trans_rgba)
+		if (rgba != trans_rgba)
 			rgba |= 0xFF;
-		col = pwi->ppi->rgba2col(pwi, rgba);
+		col = row_rgba2col(pii, rgba);
 		do {
-			shift -= pii->bpp;
-			val &= ~(pii->mask << shift);
+			shift -= bpp;
+			val &= ~(mask << shift);
 			val |= col << shift;
-			if (++xpix >= pii->xend)
+			if (++xpix >= xend)
 				goto DONE;
 			if (!shift) {
 				*p++ = val;
 				val = *p;
 				shift = 32;
 			}
-		} while (xpix % pii->multiwidth);
+		} while (--count);
+		count = multiwidth;
 		prow += 3;
 	}
 DONE:
 	*p = val; /* Store final value */
 }
+#endif /* CONFIG_XLCD_PNG || CONFIG_XLCD_JPG */
 
 
+#ifdef CONFIG_XLCD_PNG
 void draw_ll_row_RGBA(imginfo_t *pii, COLOR32 *p)
 {
 	int xpix = pii->xpix;
+	int xend = pii->xend;
 	u_int shift = pii->shift;
+	u_int bpp = pii->bpp;
 	COLOR32 val;
-	const wininfo_t *pwi = pii->pwi;
+	COLOR32 mask = pii->mask;
+	u_int multiwidth = pii->multiwidth;
+	u_int count = multiwidth - xpix % multiwidth;
 	u_char *prow = pii->prow;
 
+	if (row_is_direct(pii)) {
+		for (; xpix < xend; xpix++) {
+			RGBA rgba;
+
+			rgba = prow[0] << 24;
+			rgba |= prow[1] << 16;
+			rgba |= prow[2] << 8;
+			rgba |= prow[3];
+			*p++ = row_rgba2col(pii, rgba);
+			prow += 4;
+		}
+		return;
+	}
+
 	val = *p;
 	for (;;) {
 		RGBA rgba;
@@ -290,19 +403,20 @@ void draw_ll_row_RGBA(imginfo_t *pii, COLOR32 *p)
 		rgba |= prow[1] << 16;
 		rgba |= prow[2] << 8;
 		rgba |= prow[3];
-		col = pwi->ppi->rgba2col(pwi, rgba);
+		col = row_rgba2col(pii, rgba);
 		do {
-			shift -= pii->bpp;
-			val &= ~(pii->mask << shift);
+			shift -= bpp;
+			val &= ~(mask << shift);
 			val |= col << shift;
-			if (++xpix >= pii->xend)
+			if (++xpix >= xend)
 				goto DONE;
 			if (!shift) {
 				*p++ = val;
 				val = *p;
 				shift = 32;
 			}
-		} while (xpix % pii->multiwidth);
+		} while (--count);
+		count = multiwidth;
 		prow += 4;
 	}
 DONE:
@@ -315,11 +429,31 @@ DONE:
 void draw_ll_row_BGR(imginfo_t *pii, COLOR32 *p)
 {
 	int xpix = pii->xpix;
+	int xend = pii->xend;
 	u_int shift = pii->shift;
+	u_int bpp = pii->bpp;
 	COLOR32 val;
-	const wininfo_t *pwi = pii->pwi;
+	COLOR32 mask = pii->mask;
+	u_int multiwidth = pii->multiwidth;
+	u_int count = multiwidth - xpix % multiwidth;
+	RGBA trans_rgba = pii->trans_rgba;
 	u_char *prow = pii->prow;
 
+	if (row_is_direct(pii)) {
+		for (; xpix < xend; xpix++) {
+			RGBA rgba;
+
+			rgba = prow[0] << 8;
+			rgba |= prow[1] << 16;
+			rgba |= prow[2] << 24;
+			if (rgba != trans_rgba)
+				rgba |= 0xFF;
+			*p++ = row_rgba2col(pii, rgba);
+			prow += 3;
+		}
+		return;
+	}
+
 	val = *p;
 	for (;;) {
 		RGBA rgba;
@@ -328,21 +462,22 @@ void draw_ll_row_BGR(imginfo_t *pii, COLOR32 *p)
 		rgba = prow[0] << 8;
 		rgba |= prow[1] << 16;
 		rgba |= prow[2] << 24;
-		if (rgba != pii->trans_rgba)
+		if (rgba != trans_rgba)
 			rgba |= 0xFF;
-		col = pwi->ppi->rgba2col(pwi, rgba);
+		col = row_rgba2col(pii, rgba);
 		do {
-			shift -= pii->bpp;
-			val &= ~(pii->mask << shift);
+			shift -= bpp;
+			val &= ~(mask << shift);
 			val |= col << shift;
-			if (++xpix >= pii->xend)
+			if (++xpix >= xend)
 				goto DONE;
 			if (!shift) {
 				*p++ = val;
 				val = *p;
 				shift = 32;
 			}
-		} while (xpix % pii->multiwidth);
+		} while (--count);
+		count = multiwidth;
 		prow += 3;
 	}
 DONE:
@@ -353,11 +488,29 @@ DONE:
 void draw_ll_row_BGRA(imginfo_t *pii, COLOR32 *p)
 {
 	int xpix = pii->xpix;
+	int xend = pii->xend;
 	u_int shift = pii->shift;
+	u_int bpp = pii->bpp;
 	COLOR32 val;
-	const wininfo_t *pwi = pii->pwi;
+	COLOR32 mask = pii->mask;
+	u_int multiwidth = pii->multiwidth;
+	u_int count = multiwidth - xpix % multiwidth;
 	u_char *prow = pii->prow;
 
+	if (row_is_direct(pii)) {
+		for (; xpix < xend; xpix++) {
+			RGBA rgba;
+
+			rgba = prow[0] << 8;
+			rgba |= prow[1] << 16;
+			rgba |= prow[2] << 24;
+			rgba |= prow[3];
+			*p++ = row_rgba2col(pii, rgba);
+			prow += 4;
+		}
+		return;
+	}
+
 	val = *p;
 	for (;;) {
 		RGBA rgba;
@@ -367,19 +520,20 @@ void draw_ll_row_BGRA(imginfo_t *pii, COLOR32 *p)
 		rgba |= prow[1] << 16;
 		rgba |= prow[2] << 24;
 		rgba |= prow[3];
-		col = pwi->ppi->rgba2col(pwi, rgba);
+		col = row_rgba2col(pii, rgba);
 		do {
-			shift -= pii->bpp;
-			val &= ~(pii->mask << shift);
+			shift -= bpp;
+			val &= ~(mask << shift);
 			val |= col << shift;
-			if (++xpix >= pii->xend)
+			if (++xpix >= xend)
 				goto DONE;
 			if (!shift) {
 				*p++ = val;
 				val = *p;
 				shift = 32;
 			}
-		} while (xpix % pii->multiwidth);
+		} while (--count);
+		count = multiwidth;
 		prow += 4;
 	}
 DONE:
@@ -13,6 +13,7 @@
 
 #include <config.h>
 #include <common.h>
+#include <malloc.h>			 /* calloc() */
 #include <xlcd_draw_ll.h>		 /* Own interface */
 #include <cmd_lcd.h>			 /* wininfo_t */
 #include <video_font.h>			 /* Get font data, width and height */
@@ -20,25 +21,61 @@
 
 #if defined(CONFIG_XLCD_CONSOLE) \
 	|| (CONFIG_XLCD_DRAW & (XLCD_DRAW_TEXT | XLCD_DRAW_PROG))
-/* Draw a character, replacing pixels with new color; character area is
-   definitely valid */
-void draw_ll_char(const wininfo_t *pwi, XYPOS x, XYPOS y, char c,
-		  COLOR32 fg, COLOR32 bg)
+
+/************************************************************************/
+/* DEFINITIONS								*/
+/************************************************************************/
+
+/* Number of glyphs in the glyph cache (power of 2) */
+#define GLYPH_CACHE_SIZE 128
+
+/* Maximum size of one glyph row in the cache (in 32-bit words); this is
+   enough for a single width character with 32 bpp */
+#define GLYPH_WORDS	(VIDEO_FONT_WIDTH)
+
+/* Attributes that change the appearance of a cached glyph */
+#define GLYPH_ATTR	(ATTR_HS_MASK | ATTR_BOLD | ATTR_INVERSE \
+			 | ATTR_UNDERL | ATTR_STRIKE)
+
+/************************************************************************/
+/* TYPES AND STRUCTURES							*/
+/************************************************************************/
+
+/* Glyph converted to the native framebuffer format, one row per font row */
+typedef struct glyph {
+	const pixinfo_t *ppi;		 /* Pixel format, NULL: unused */
+	COLOR32 fg;			 /* Foreground and background */
+	COLOR32 bg;
+	u_int attr;			 /* Attributes (only GLYPH_ATTR) */
+	u_char c;			 /* Character */
+	/* One additional word because render_char() loads the word behind
+	   a row if the row ends on a word boundary */
+	COLOR32 data[VIDEO_FONT_HEIGHT * GLYPH_WORDS + 1];
+} glyph_t;
+
+/************************************************************************/
+/* LOCAL VARIABLES							*/
+/************************************************************************/
+
+static glyph_t *glyph_cache;		 /* Allocated on first use */
+static int glyph_cache_failed;		 /* Allocation failed, no cache */
+
+/************************************************************************/
+/* DRAWING CHARACTERS							*/
+/************************************************************************/
+
+/* Render a character bit by bit to the given buffer; every font row is
+   repeated line_count times */
+static void render_char(u_long fbuf, u_long linelen, u_int shift,
+			u_int bpp_shift, u_int attr, u_int line_count,
+			char c, COLOR32 fg, COLOR32 bg)
 {
-	u_int bpp_shift = pwi->ppi->bpp_shift;
 	u_int bpp = 1 << bpp_shift;
-	int xpos = x << bpp_shift;
-	u_long fbuf;
-	u_long linelen = pwi->linelen;
-	u_int attr = pwi->attr;
 	XYPOS underl = (attr & ATTR_UNDERL) ? VIDEO_FONT_UNDERL : -1;
 	XYPOS strike = (attr & ATTR_STRIKE) ? VIDEO_FONT_STRIKE : -1;
 	const VIDEO_FONT_TYPE *pfont;
 	COLOR32 mask = (1 << bpp) - 1;	  /* This also works for bpp==32! */
-	u_int shift = 32 - (xpos & 31);
-
-	/* Compute framebuffer address of the pixel */
-	fbuf = linelen * y + ((xpos >> 5) << 2) + pwi->pfbuf[pwi->fbdraw];
+	XYPOS y;
 
 	/* Compute start of character within font data */
 	pfont = video_fontdata;
@@ -46,7 +83,7 @@ void draw_ll_char(const wininfo_t *pwi, XYPOS x, XYPOS y, char c,
 
 	for (y = 0; y < VIDEO_FONT_HEIGHT; y++) {
 		VIDEO_FONT_TYPE fd;	  /* Font data (one character row) */
-		unsigned line_count;	  /* Loop twice if double height */
+		u_int count = line_count; /* Loop twice if double height */
 
 		/* If underline or strike-through line is reached, use fully
 		   set pixel, otherwise get character pixel data and apply
@@ -63,7 +100,6 @@ void draw_ll_char(const wininfo_t *pwi, XYPOS x, XYPOS y, char c,
 		pfont++;		  /* Next character row */
 
 		/* Loop up to four times if multiple height */
-		line_count = ((attr & ATTR_VS_MASK) >> 6) + 1;
 		do {
 			COLOR32 *p = (COLOR32 *)fbuf;
 			u_int s = shift;
@@ -108,7 +144,94 @@ void draw_ll_char(const wininfo_t *pwi, XYPOS x, XYPOS y, char c,
 
 			/* Go to next line */
 			fbuf += linelen;
-		} while (--line_count);
+		} while (--count);
 	}
 }
+
+/* Get the glyph for the character from the glyph cache; if it is not there
+   yet, render it to the cache. The cache is direct mapped, so a glyph simply
+   replaces any other glyph in its slot. Return NULL if there is no cache. */
+static const COLOR32 *get_glyph(const wininfo_t *pwi, char c,
+				COLOR32 fg, COLOR32 bg, u_int words)
+{
+	glyph_t *pg;
+	u_int attr = pwi->attr & GLYPH_ATTR;
+	u_int index;
+
+	if (!glyph_cache) {
+		if (glyph_cache_failed)
+			return NULL;
+		glyph_cache = calloc(GLYPH_CACHE_SIZE, sizeof(glyph_t));
+		if (!glyph_cache) {
+			glyph_cache_failed = 1;
+			return NULL;
+		}
+	}
+
+	index = ((u_char)c ^ (fg * 7) ^ (bg * 13) ^ attr);
+	pg = &glyph_cache[index & (GLYPH_CACHE_SIZE - 1)];
+	if ((pg->ppi != pwi->ppi) || (pg->c != (u_char)c) || (pg->fg != fg)
+	    || (pg->bg != bg) || (pg->attr != attr)) {
+		/* Render glyph with single height, all pixels are set */
+		pg->ppi = pwi->ppi;
+		pg->c = (u_char)c;
+		pg->fg = fg;
+		pg->bg = bg;
+		pg->attr = attr;
+		render_char((u_long)pg->data, words * sizeof(COLOR32), 32,
+			    pwi->ppi->bpp_shift, attr, 1, c, fg, bg);
+	}
+
+	return pg->data;
+}
+
+/* Draw a character, replacing pixels with new color; character area is
+   definitely valid. If the character starts and ends on a word boundary in
+   the framebuffer and the background is drawn, we can simply copy the rows
+   of the pre-rendered glyph from the glyph cache. */
+void draw_ll_char(const wininfo_t *pwi, XYPOS x, XYPOS y, char c,
+		  COLOR32 fg, COLOR32 bg)
+{
+	u_int bpp_shift = pwi->ppi->bpp_shift;
+	int xpos = x << bpp_shift;
+	u_long fbuf;
+	u_long linelen = pwi->linelen;
+	u_int attr = pwi->attr;
+	u_int line_count = ((attr & ATTR_VS_MASK) >> 6) + 1;
+	XYPOS width = VIDEO_FONT_WIDTH * (((attr & ATTR_HS_MASK) >> 4) + 1);
+	XYPOS height = VIDEO_FONT_HEIGHT * line_count;
+	u_int bits = width << bpp_shift;
+
+	lcd_damage(pwi, x, y, x + width - 1, y + height - 1);
+
+	/* Compute framebuffer address of the pixel */
+	fbuf = linelen * y + ((xpos >> 5) << 2) + pwi->pfbuf[pwi->fbdraw];
+
+	if (!(attr & ATTR_NO_BG) && !(xpos & 31) && !(bits & 31)
+	    && (bits <= GLYPH_WORDS * 32)) {
+		const COLOR32 *pdata;
+		u_int words = bits >> 5;
+
+		pdata = get_glyph(pwi, c, fg, bg, words);
+		if (pdata) {
+			for (y = 0; y < VIDEO_FONT_HEIGHT; y++) {
+				u_int count = line_count;
+
+				do {
+					COLOR32 *p = (COLOR32 *)fbuf;
+					u_int i;
+
+					for (i = 0; i < words; i++)
+						p[i] = pdata[i];
+					fbuf += linelen;
+				} while (--count);
+				pdata += words;
+			}
+			return;
+		}
+	}
+
+	render_char(fbuf, linelen, 32 - (xpos & 31), bpp_shift, attr,
+		    line_count, c, fg, bg);
+}
 #endif
@@ -1,5 +1,5 @@
 /*
- * Hardware independent LCD support for BMP files
+ * Hardware independent LCD support for JPG files
  *
  * (C) Copyright 2012
  * Hartmut Keller, F&S Elektronik Systeme GmbH, keller@fs-net.de
@@ -11,6 +11,7 @@
 #include <common.h>
 #include <cmd_lcd.h>			  /* wininfo_t, pixinfo_t */
 #include <xlcd_bitmap.h>		  /* bminfo_t, CT_*, ... */
+#include <malloc.h>			  /* malloc(), free() */
 #include <watchdog.h>			  /* WATCHDOG_RESET() */
 
 #ifdef CONFIG_CMD_DRAW
@@ -27,34 +28,1269 @@
 /* DEFINITIONS								*/
 /************************************************************************/
 
+/* JPG markers (the byte following 0xFF) */
+#define M_SOF0 0xC0			  /* Start of frame, baseline DCT */
+#define M_SOF1 0xC1			  /* Start of frame, extended DCT */
+#define M_SOF2 0xC2			  /* Start of frame, progressive DCT */
+#define M_DHT  0xC4			  /* Define Huffman tables */
+#define M_JPG  0xC8			  /* Reserved for JPG extensions */
+#define M_DAC  0xCC			  /* Define arithmetic coding cond. */
+#define M_RST0 0xD0			  /* Restart marker 0 */
+#define M_RST7 0xD7			  /* Restart marker 7 */
+#define M_SOI  0xD8			  /* Start of image */
+#define M_EOI  0xD9			  /* End of image */
+#define M_SOS  0xDA			  /* Start of scan */
+#define M_DQT  0xDB			  /* Define quantization tables */
+#define M_DRI  0xDD			  /* Define restart interval */
+
+/* Largest supported image width and height; keeps all buffer sizes sane */
+#define JPG_MAX_RES 8192
+
+/* Number of bits that are decoded by a single Huffman table lookup */
+#define JPG_FAST_BITS 9
+
+/* Fixed point constants for the IDCT, scaled by 2^13 */
+#define IDCT_CONST_BITS 13
+#define IDCT_PASS1_BITS 2
+#define FIX_0_298631336 2446
+#define FIX_0_390180644 3196
+#define FIX_0_541196100 4433
+#define FIX_0_765366865 6270
+#define FIX_0_899976223 7373
+#define FIX_1_175875602 9633
+#define FIX_1_501321110 12299
+#define FIX_1_847759065 15137
+#define FIX_1_961570560 16069
+#define FIX_2_053119869 16819
+#define FIX_2_562915447 20995
+#define FIX_3_072711026 25172
+
+/* Shift right with rounding */
+#define DESCALE(x, n) (((x) + (1 << ((n) - 1))) >> (n))
+
+/* Huffman table */
+typedef struct JPGHUFF {
+	u_char fast[1 << JPG_FAST_BITS];  /* Symbol index for short codes */
+	u_char size[257];		  /* Code length of each symbol */
+	u_char values[256];		  /* Symbol values */
+	u_int maxcode[18];		  /* End of codes per length (16 bits) */
+	int delta[17];			  /* Code to symbol index offset */
+} jpghuff_t;
+
+/* Image component (Y, Cb or Cr) */
+typedef struct JPGCOMP {
+	u_char id;			  /* Component ID from frame header */
+	u_char h;			  /* Horizontal sampling factor */
+	u_char v;			  /* Vertical sampling factor */
+	u_char tq;			  /* Quantization table index */
+	u_char td;			  /* DC Huffman table index */
+	u_char ta;			  /* AC Huffman table index */
+	int dcpred;			  /* DC predictor */
+	int bw;				  /* Blocks per row (MCU aligned) */
+	int bh;				  /* Blocks per column (MCU aligned) */
+	int xsize;			  /* Component width in samples */
+	int ysize;			  /* Component height in samples */
+	int bx0;			  /* First visible block column */
+	int bx1;			  /* Last visible block column + 1 */
+	int stride;			  /* Line length of pix */
+	u_char *pix;			  /* Samples of one MCU row */
+	short *coef;			  /* Coefficients of all blocks */
+} jpgcomp_t;
+
+/* Decoder state */
+typedef struct JPGDEC {
+	u_char *p;			  /* Current read position */
+	u_char *end;			  /* End of JPG data (after EOI) */
+	u_int bits;			  /* Bit buffer, left aligned */
+	int nbits;			  /* Number of valid bits in bits */
+	u_char marker;			  /* Marker hit in entropy coded data */
+	u_char progressive;		  /* 1: progressive DCT (SOF2) */
+	u_char buffered;		  /* 1: decode all scans to coef */
+	int hres;			  /* Image width */
+	int vres;			  /* Image height */
+	int ncomp;			  /* Number of image components */
+	int hmax;			  /* Maximum horizontal sampling */
+	int vmax;			  /* Maximum vertical sampling */
+	int mcux;			  /* Number of MCUs per row */
+	int mcuy;			  /* Number of MCU rows */
+	int restart;			  /* Restart interval (in MCUs) */
+	int todo;			  /* MCUs until next restart marker */
+	int eobrun;			  /* Remaining end-of-band run */
+	int ns;				  /* Number of components in scan */
+	int ss;				  /* Start of spectral selection */
+	int se;				  /* End of spectral selection */
+	int ah;				  /* Successive approximation high */
+	int al;				  /* Successive approximation low */
+	int x0;				  /* First visible column */
+	int x1;				  /* Last visible column + 1 */
+	jpgcomp_t *scomp[3];		  /* Components in current scan */
+	jpgcomp_t comp[3];		  /* Image components */
+	u_char *rgb;			  /* Color converted row */
+	u_char *up[3];			  /* Upsampled Y, Cb and Cr row */
+	short blk[64];			  /* Coefficients of current block */
+	u_short qt[4][64];		  /* Quantization tables */
+	jpghuff_t dc[4];		  /* DC Huffman tables */
+	jpghuff_t ac[4];		  /* AC Huffman tables */
+} jpgdec_t;
+
+
 /************************************************************************/
 /* LOCAL VARIABLES							*/
 /************************************************************************/
 
+/* Index in an 8x8 block for each coefficient in zig-zag order; the 16 extra
+   entries catch overruns in corrupt data */
+static const u_char jpg_zigzag[64 + 16] = {
+	 0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+	12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+	63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63
+};
+
+static RGBA palette[256];
+
+
 /************************************************************************/
 /* Local Helper Functions						*/
 /************************************************************************/
 
+/* Get a big endian 16 bit number from address p (may be unaligned) */
+static u_int get_be16(u_char *p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+/* Limit value to 0..255 */
+static u_char jpg_clamp(int val)
+{
+	if ((u_int)val > 255)
+		return (val < 0) ? 0 : 255;
+
+	return (u_char)val;
+}
+
+/* Check if marker is one of the SOFn markers */
+static int jpg_is_sof(u_char m)
+{
+	return (m >= M_SOF0) && (m <= 0xCF) && (m != M_DHT) && (m != M_JPG)
+		&& (m != M_DAC);
+}
+
+/* Build the lookup tables for a Huffman table from the DHT code counts and
+   symbol values in the len bytes at p; return number of bytes used or 0 on
+   error */
+static int jpg_build_huff(jpghuff_t *ph, u_char *p, int len)
+{
+	int i, j, k;
+	u_int code;
+
+	/* Get the code length of each symbol */
+	if (len < 16)
+		return 0;
+	k = 0;
+	for (i = 0; i < 16; i++) {
+		for (j = 0; j < p[i]; j++) {
+			if (k >= 256)
+				return 0;
+			ph->size[k++] = i + 1;
+		}
+	}
+	if (16 + k > len)
+		return 0;
+	ph->size[k] = 0;
+	memcpy(ph->values, p + 16, k);
+
+	/* Assign the canonical codes; for each length we remember the end of
+	   the codes (aligned to 16 bits) and how to get from code to index */
+	code = 0;
+	k = 0;
+	for (j = 1; j <= 16; j++) {
+		ph->delta[j] = k - code;
+		while (ph->size[k] == j) {
+			k++;
+			code++;
+		}
+		if (code > (1U << j))
+			return 0;
+		ph->maxcode[j] = code << (16 - j);
+		code <<= 1;
+	}
+	ph->maxcode[17] = 0xFFFFFFFF;
+
+	/* Fill the lookup table for short codes */
+	memset(ph->fast, 0xFF, sizeof(ph->fast));
+	for (i = 0; i < k; i++) {
+		int s = ph->size[i];
+
+		if (s <= JPG_FAST_BITS) {
+			code = (i - ph->delta[s]) << (JPG_FAST_BITS - s);
+			for (j = 0; j < (1 << (JPG_FAST_BITS - s)); j++)
+				ph->fast[code + j] = i;
+		}
+	}
+
+	return 16 + k;
+}
+
+/* Find the next marker, skipping any remaining entropy coded data and fill
+   bytes; this also resets the bit buffer; return 0 at the end of the data */
+static u_char jpg_next_marker(jpgdec_t *jd)
+{
+	u_char *p = jd->p;
+	u_char m = 0;
+
+	while (p < jd->end) {
+		if (*p++ == 0xFF) {
+			while ((p < jd->end) && (*p == 0xFF))
+				p++;
+			if ((p < jd->end) && *p) {
+				m = *p++;
+				break;
+			}
+		}
+	}
+	jd->p = p;
+	jd->bits = 0;
+	jd->nbits = 0;
+	jd->marker = 0;
+
+	return m;
+}
+
+/* Fill the bit buffer with at least 25 bits; remove stuffed zero bytes and
+   stop at markers or at the end of the data, in this case fill with zeroes */
+static void jpg_fill(jpgdec_t *jd)
+{
+	while (jd->nbits <= 24) {
+		u_int c = 0;
+
+		if (!jd->marker && (jd->end - jd->p < 2))
+			jd->marker = M_EOI;
+		if (!jd->marker) {
+			c = *jd->p;
+			if (c != 0xFF)
+				jd->p++;
+			else if (!jd->p[1])
+				jd->p += 2;	  /* Stuffed zero byte */
+			else {
+				jd->marker = jd->p[1];
+				c = 0;
+			}
+		}
+		jd->bits |= c << (24 - jd->nbits);
+		jd->nbits += 8;
+	}
+}
+
+/* Get n bits (1..16) as unsigned value */
+static int jpg_bits(jpgdec_t *jd, int n)
+{
+	u_int val;
+
+	if (jd->nbits < n)
+		jpg_fill(jd);
+	val = jd->bits >> (32 - n);
+	jd->bits <<= n;
+	jd->nbits -= n;
+
+	return val;
+}
+
+/* Get a single bit */
+static int jpg_bit(jpgdec_t *jd)
+{
+	return jpg_bits(jd, 1);
+}
+
+/* Get n bits (0..16) and extend to a signed value */
+static int jpg_extend(jpgdec_t *jd, int n)
+{
+	int val;
+
+	if (!n)
+		return 0;
+	val = jpg_bits(jd, n);
+	if (val < (1 << (n - 1)))
+		val -= (1 << n) - 1;
+
+	return val;
+}
+
+/* Decode one Huffman coded symbol; return -1 on invalid code */
+static int jpg_huff(jpgdec_t *jd, const jpghuff_t *ph)
+{
+	int k, len;
+
+	if (jd->nbits < 16)
+		jpg_fill(jd);
+
+	/* Short codes are found with a single table lookup */
+	k = ph->fast[jd->bits >> (32 - JPG_FAST_BITS)];
+	if (k != 0xFF)
+		len = ph->size[k];
+	else {
+		u_int code = jd->bits >> 16;
+
+		for (len = JPG_FAST_BITS + 1; code >= ph->maxcode[len]; len++)
+			;
+		if (len > 16)
+			return -1;
+		k = (jd->bits >> (32 - len)) + ph->delta[len];
+		if (((u_int)k >= 256) || (ph->size[k] != len))
+			return -1;
+	}
+	jd->bits <<= len;
+	jd->nbits -= len;
+
+	return ph->values[k];
+}
+
+/* Decode a full block of a sequential scan */
+static int jpg_decode_block(jpgdec_t *jd, jpgcomp_t *pc, short *blk)
+{
+	const jpghuff_t *ph = &jd->ac[pc->ta];
+	int k, s;
+
+	memset(blk, 0, 64 * sizeof(short));
+
+	s = jpg_huff(jd, &jd->dc[pc->td]);
+	if ((s < 0) || (s > 15))
+		return -1;
+	pc->dcpred += jpg_extend(jd, s);
+	blk[0] = pc->dcpred;
+
+	for (k = 1; k < 64; k++) {
+		s = jpg_huff(jd, ph);
+		if (s < 0)
+			return -1;
+		if (!(s & 15)) {
+			if (s != 0xF0)
+				break;		  /* EOB */
+			k += 15;		  /* ZRL: 16 zeroes */
+			continue;
+		}
+		k += s >> 4;
+		if (k > 63)
+			return -1;
+		blk[jpg_zigzag[k]] = jpg_extend(jd, s & 15);
+	}
+
+	return 0;
+}
+
+/* Progressive: first DC scan of a block */
+static int jpg_dc_first(jpgdec_t *jd, jpgcomp_t *pc, short *blk)
+{
+	int s;
+
+	s = jpg_huff(jd, &jd->dc[pc->td]);
+	if ((s < 0) || (s > 15))
+		return -1;
+	pc->dcpred += jpg_extend(jd, s);
+	blk[0] = pc->dcpred * (1 << jd->al);
+
+	return 0;
+}
+
+/* Progressive: DC refinement scan of a block */
+static int jpg_dc_refine(jpgdec_t *jd, short *blk)
+{
+	if (jpg_bit(jd))
+		blk[0] |= 1 << jd->al;
+
+	return 0;
+}
+
+/* Progressive: first AC scan of a block */
+static int jpg_ac_first(jpgdec_t *jd, jpgcomp_t *pc, short *blk)
+{
+	const jpghuff_t *ph = &jd->ac[pc->ta];
+	int k, r, s;
+
+	if (jd->eobrun) {
+		jd->eobrun--;
+		return 0;
+	}
+
+	for (k = jd->ss; k <= jd->se; k++) {
+		s = jpg_huff(jd, ph);
+		if (s < 0)
+			return -1;
+		r = s >> 4;
+		s &= 15;
+		if (!s) {
+			if (r < 15) {
+				/* EOBn: this and the next blocks are done */
+				jd->eobrun = (1 << r) - 1;
+				if (r)
+					jd->eobrun += jpg_bits(jd, r);
+				break;
+			}
+			k += 15;		  /* ZRL: 16 zeroes */
+			continue;
+		}
+		k += r;
+		if (k > 63)
+			return -1;
+		blk[jpg_zigzag[k]] = jpg_extend(jd, s) * (1 << jd->al);
+	}
+
+	return 0;
+}
+
+/* Progressive: refine a non-zero AC coefficient */
+static void jpg_ac_correct(jpgdec_t *jd, short *coef)
+{
+	int p1 = 1 << jd->al;
+
+	if (jpg_bit(jd) && !(*coef & p1)) {
+		if (*coef >= 0)
+			*coef += p1;
+		else
+			*coef -= p1;
+	}
+}
+
+/* Progressive: AC refinement scan of a block; all non-zero coefficients
+   get a correction bit, zero coefficients may become +/-1 */
+static int jpg_ac_refine(jpgdec_t *jd, jpgcomp_t *pc, short *blk)
+{
+	const jpghuff_t *ph = &jd->ac[pc->ta];
+	int p1 = 1 << jd->al;
+	int k = jd->ss;
+	int r, s;
+
+	if (!jd->eobrun) {
+		for (; k <= jd->se; k++) {
+			s = jpg_huff(jd, ph);
+			if (s < 0)
+				return -1;
+			r = s >> 4;
+			s &= 15;
+			if (s) {
+				if (s != 1)
+					return -1;
+				s = jpg_bit(jd) ? p1 : -p1;
+			} else if (r != 15) {
+				/* EOBn: handle rest of block below */
+				jd->eobrun = 1 << r;
+				if (r)
+					jd->eobrun += jpg_bits(jd, r);
+				break;
+			}
+
+			/* Skip r zero coefficients, refine non-zero ones */
+			do {
+				short *coef = &blk[jpg_zigzag[k]];
+
+				if (*coef)
+					jpg_ac_correct(jd, coef);
+				else if (--r < 0)
+					break;
+			} while (++k <= jd->se);
+
+			if (s)
+				blk[jpg_zigzag[k]] = s;
+		}
+	}
+
+	if (jd->eobrun) {
+		/* Within an EOB run, only refine non-zero coefficients */
+		for (; k <= jd->se; k++) {
+			short *coef = &blk[jpg_zigzag[k]];
+
+			if (*coef)
+				jpg_ac_correct(jd, coef);
+		}
+		jd->eobrun--;
+	}
+
+	return 0;
+}
+
+/* Dequantize and do the inverse DCT of a block, store the 8x8 samples at
+   out. This is an integer version of the Loeffler-Ligtenberg-Moschytz
+   algorithm as used by the IJG library (jidctint.c), with 13 bit fixed
+   point constants. Columns and rows with only a DC value are short-cut. */
+static void jpg_idct(const short *blk, const u_short *qt, u_char *out,
+		     int stride)
+{
+	int ws[64];
+	int *pw;
+	int i;
+	int tmp0, tmp1, tmp2, tmp3;
+	int tmp10, tmp11, tmp12, tmp13;
+	int z1, z2, z3, z4, z5;
+
+	/* Pass 1: process columns from input, store into work array */
+	for (i = 0; i < 8; i++, blk++, qt++) {
+		pw = ws + i;
+		if (!blk[8] && !blk[16] && !blk[24] && !blk[32] && !blk[40]
+		    && !blk[48] && !blk[56]) {
+			int dc = blk[0] * qt[0] * (1 << IDCT_PASS1_BITS);
+
+			pw[0] = pw[8] = pw[16] = pw[24] = dc;
+			pw[32] = pw[40] = pw[48] = pw[56] = dc;
+			continue;
+		}
+
+		/* Even part */
+		z2 = blk[16] * qt[16];
+		z3 = blk[48] * qt[48];
+		z1 = (z2 + z3) * FIX_0_541196100;
+		tmp2 = z1 - z3 * FIX_1_847759065;
+		tmp3 = z1 + z2 * FIX_0_765366865;
+		z2 = blk[0] * qt[0];
+		z3 = blk[32] * qt[32];
+		tmp0 = (z2 + z3) * (1 << IDCT_CONST_BITS);
+		tmp1 = (z2 - z3) * (1 << IDCT_CONST_BITS);
+		tmp10 = tmp0 + tmp3;
+		tmp13 = tmp0 - tmp3;
+		tmp11 = tmp1 + tmp2;
+		tmp12 = tmp1 - tmp2;
+
+		/* Odd part */
+		tmp0 = blk[56] * qt[56];
+		tmp1 = blk[40] * qt[40];
+		tmp2 = blk[24] * qt[24];
+		tmp3 = blk[8] * qt[8];
+		z1 = tmp0 + tmp3;
+		z2 = tmp1 + tmp2;
+		z3 = tmp0 + tmp2;
+		z4 = tmp1 + tmp3;
+		z5 = (z3 + z4) * FIX_1_175875602;
+		tmp0 *= FIX_0_298631336;
+		tmp1 *= FIX_2_053119869;
+		tmp2 *= FIX_3_072711026;
+		tmp3 *= FIX_1_501321110;
+		z1 *= -FIX_0_899976223;
+		z2 *= -FIX_2_562915447;
+		z3 = z3 * -FIX_1_961570560 + z5;
+		z4 = z4 * -FIX_0_390180644 + z5;
+		tmp0 += z1 + z3;
+		tmp1 += z2 + z4;
+		tmp2 += z2 + z3;
+		tmp3 += z1 + z4;
+
+#define PASS1(x) DESCALE(x, IDCT_CONST_BITS - IDCT_PASS1_BITS)
+		pw[0] = PASS1(tmp10 + tmp3);
+		pw[56] = PASS1(tmp10 - tmp3);
+		pw[8] = PASS1(tmp11 + tmp2);
+		pw[48] = PASS1(tmp11 - tmp2);
+		pw[16] = PASS1(tmp12 + tmp1);
+		pw[40] = PASS1(tmp12 - tmp1);
+		pw[24] = PASS1(tmp13 + tmp0);
+		pw[32] = PASS1(tmp13 - tmp0);
+#undef PASS1
+	}
+
+	/* Pass 2: process rows from work array, store into output; the
+	   rounding value and the level shift of 128 are folded into the DC
+	   value right away */
+	for (i = 0, pw = ws; i < 8; i++, pw += 8, out += stride) {
+		int dc = pw[0] + (1 << (IDCT_PASS1_BITS + 2)) + (128 << 5);
+
+		if (!pw[1] && !pw[2] && !pw[3] && !pw[4] && !pw[5] && !pw[6]
+		    && !pw[7]) {
+			u_char val = jpg_clamp(dc >> (IDCT_PASS1_BITS + 3));
+
+			memset(out, val, 8);
+			continue;
+		}
+
+		/* Even part */
+		z2 = pw[2];
+		z3 = pw[6];
+		z1 = (z2 + z3) * FIX_0_541196100;
+		tmp2 = z1 - z3 * FIX_1_847759065;
+		tmp3 = z1 + z2 * FIX_0_765366865;
+		tmp0 = (dc + pw[4]) * (1 << IDCT_CONST_BITS);
+		tmp1 = (dc - pw[4]) * (1 << IDCT_CONST_BITS);
+		tmp10 = tmp0 + tmp3;
+		tmp13 = tmp0 - tmp3;
+		tmp11 = tmp1 + tmp2;
+		tmp12 = tmp1 - tmp2;
+
+		/* Odd part */
+		tmp0 = pw[7];
+		tmp1 = pw[5];
+		tmp2 = pw[3];
+		tmp3 = pw[1];
+		z1 = tmp0 + tmp3;
+		z2 = tmp1 + tmp2;
+		z3 = tmp0 + tmp2;
+		z4 = tmp1 + tmp3;
+		z5 = (z3 + z4) * FIX_1_175875602;
+		tmp0 *= FIX_0_298631336;
+		tmp1 *= FIX_2_053119869;
+		tmp2 *= FIX_3_072711026;
+		tmp3 *= FIX_1_501321110;
+		z1 *= -FIX_0_899976223;
+		z2 *= -FIX_2_562915447;
+		z3 = z3 * -FIX_1_961570560 + z5;
+		z4 = z4 * -FIX_0_390180644 + z5;
+		tmp0 += z1 + z3;
+		tmp1 += z2 + z4;
+		tmp2 += z2 + z3;
+		tmp3 += z1 + z4;
+
+		/* Rounding is already included in dc, so simply shift */
+#define PASS2(x) jpg_clamp((x) >> (IDCT_CONST_BITS + IDCT_PASS1_BITS + 3))
+		out[0] = PASS2(tmp10 + tmp3);
+		out[7] = PASS2(tmp10 - tmp3);
+		out[1] = PASS2(tmp11 + tmp2);
+		out[6] = PASS2(tmp11 - tmp2);
+		out[2] = PASS2(tmp12 + tmp1);
+		out[5] = PASS2(tmp12 - tmp1);
+		out[3] = PASS2(tmp13 + tmp0);
+		out[4] = PASS2(tmp13 - tmp0);
+#undef PASS2
+	}
+}
+
+/* Handle restart interval before decoding the next MCU */
+static int jpg_check_restart(jpgdec_t *jd)
+{
+	int i;
+	u_char m;
+
+	if (!jd->restart)
+		return 0;
+	if (jd->todo--)
+		return 0;
+
+	/* Expect a RSTn marker and reset the decoder state */
+	m = jpg_next_marker(jd);
+	if ((m < M_RST0) || (m > M_RST7))
+		return -1;
+	for (i = 0; i < jd->ncomp; i++)
+		jd->comp[i].dcpred = 0;
+	jd->eobrun = 0;
+	jd->todo = jd->restart - 1;
+
+	return 0;
+}
+
+/* Read marker segments up to the next SOS or EOI marker; return this marker
+   in *pm; after SOS, jd->p points to the entropy coded data */
+static const char *jpg_markers(jpgdec_t *jd, u_char *pm)
+{
+	int i, n;
+
+	for (;;) {
+		u_char m = jpg_next_marker(jd);
+		u_char *p = jd->p;
+		int len;
+
+		*pm = m;
+		if (!m)
+			return "Unexpected end of JPG data\n";
+		if (m == M_EOI)
+			return NULL;
+		if ((m == M_SOI) || ((m >= M_RST0) && (m <= M_RST7)))
+			continue;		  /* Markers without data */
+
+		/* All other markers have a segment with a length field */
+		if (jd->end - p < 2)
+			return "Unexpected end of JPG data\n";
+		len = get_be16(p);
+		if ((len < 2) || (len > jd->end - p))
+			return "Invalid JPG segment length\n";
+		jd->p = p + len;
+		p += 2;
+		len -= 2;
+
+		switch (m) {
+		case M_SOF0:
+		case M_SOF1:
+		case M_SOF2:
+			if (jd->ncomp)
+				return "Multiple JPG frames not supported\n";
+			if ((len < 6) || (len < 6 + 3*p[5]))
+				return "Invalid JPG frame header\n";
+			if (p[0] != 8)
+				return "Unsupported JPG sample precision\n";
+			jd->progressive = (m == M_SOF2);
+			jd->vres = get_be16(p + 1);
+			jd->hres = get_be16(p + 3);
+			n = p[5];
+			if (!jd->vres || !jd->hres)
+				return "Invalid JPG image size\n";
+			if ((jd->vres > JPG_MAX_RES) || (jd->hres > JPG_MAX_RES))
+				return "JPG image too large\n";
+			if ((n != 1) && (n != 3))
+				return "Unsupported number of JPG components\n";
+			jd->ncomp = n;
+			for (i = 0; i < n; i++) {
+				jpgcomp_t *pc = &jd->comp[i];
+
+				pc->id = p[6 + 3*i];
+				pc->h = p[7 + 3*i] >> 4;
+				pc->v = p[7 + 3*i] & 15;
+				pc->tq = p[8 + 3*i] & 3;
+				if (!pc->h || (pc->h > 4) || !pc->v || (pc->v > 4))
+					return "Invalid JPG sampling factor\n";
+			}
+			break;
+
+		case M_DHT:
+			while (len > 0) {
+				jpghuff_t *ph;
+
+				if (p[0] & 0xEC)
+					return "Invalid JPG Huffman table\n";
+				ph = (p[0] & 0x10) ? jd->ac : jd->dc;
+				n = jpg_build_huff(ph + (p[0] & 3), p + 1,
+						   len - 1);
+				if (!n)
+					return "Invalid JPG Huffman table\n";
+				p += n + 1;
+				len -= n + 1;
+			}
+			break;
+
+		case M_DQT:
+			while (len > 0) {
+				u_short *qt = jd->qt[p[0] & 3];
+
+				n = (p[0] >> 4) ? 129 : 65;
+				if (n > len)
+					return "Invalid JPG quantization table\n";
+				if (p[0] >> 4) {
+					for (i = 0; i < 64; i++)
+						qt[jpg_zigzag[i]] =
+							get_be16(p + 1 + 2*i);
+				} else {
+					for (i = 0; i < 64; i++)
+						qt[jpg_zigzag[i]] = p[1 + i];
+				}
+				p += n;
+				len -= n;
+			}
+			break;
+
+		case M_DRI:
+			if (len < 2)
+				return "Invalid JPG restart interval\n";
+			jd->restart = get_be16(p);
+			break;
+
+		case M_SOS:
+			if (!jd->ncomp)
+				return "Missing JPG frame header\n";
+			if (len < 1)
+				return "Invalid JPG scan header\n";
+			n = p[0];
+			if (!n || (n > jd->ncomp) || (len < 2*n + 4))
+				return "Invalid JPG scan header\n";
+			jd->ns = n;
+			for (i = 0; i < n; i++) {
+				jpgcomp_t *pc = NULL;
+				int j;
+
+				for (j = 0; j < jd->ncomp; j++) {
+					if (jd->comp[j].id == p[1 + 2*i])
+						pc = &jd->comp[j];
+				}
+				if (!pc)
+					return "Invalid JPG scan header\n";
+				pc->td = (p[2 + 2*i] >> 4) & 3;
+				pc->ta = p[2 + 2*i] & 3;
+				pc->dcpred = 0;
+				jd->scomp[i] = pc;
+			}
+			p += 2*n + 1;
+			jd->ss = p[0];
+			jd->se = p[1];
+			jd->ah = p[2] >> 4;
+			jd->al = p[2] & 15;
+			if (jd->progressive) {
+				if ((jd->se > 63) || (jd->ss > jd->se)
+				    || (!jd->ss && jd->se)
+				    || (jd->ss && (n != 1))
+				    || (jd->al > 13) || (jd->ah > 13))
+					return "Invalid JPG progression\n";
+			} else if (jd->ss || (jd->se != 63) || jd->ah
+				   || jd->al)
+				return "Invalid JPG scan header\n";
+			jd->eobrun = 0;
+			jd->todo = jd->restart;
+			return NULL;
+
+		default:
+			if (jpg_is_sof(m))
+				return "Unsupported JPG compression type\n";
+			break;			  /* Ignore APPn, COM, ... */
+		}
+	}
+}
+
+/* Compute the component layout and allocate the buffers; only the visible
+   columns x0..x1-1 need to be decoded */
+static const char *jpg_setup(jpgdec_t *jd, int x0, int x1)
+{
+	int i;
+
+	/* A single component is never interleaved, ignore sampling */
+	if (jd->ncomp == 1)
+		jd->comp[0].h = jd->comp[0].v = 1;
+
+	jd->hmax = 1;
+	jd->vmax = 1;
+	for (i = 0; i < jd->ncomp; i++) {
+		if (jd->hmax < jd->comp[i].h)
+			jd->hmax = jd->comp[i].h;
+		if (jd->vmax < jd->comp[i].v)
+			jd->vmax = jd->comp[i].v;
+	}
+	jd->mcux = (jd->hres + 8*jd->hmax - 1) / (8*jd->hmax);
+	jd->mcuy = (jd->vres + 8*jd->vmax - 1) / (8*jd->vmax);
+	jd->x0 = x0;
+	jd->x1 = x1;
+
+	/* If the scan does not hold all components, we also need to buffer
+	   the coefficients of a sequential image */
+	jd->buffered = jd->progressive || (jd->ns != jd->ncomp);
+
+	for (i = 0; i < jd->ncomp; i++) {
+		jpgcomp_t *pc = &jd->comp[i];
+
+		pc->bw = jd->mcux * pc->h;
+		pc->bh = jd->mcuy * pc->v;
+		pc->xsize = (jd->hres * pc->h + jd->hmax - 1) / jd->hmax;
+		pc->ysize = (jd->vres * pc->v + jd->vmax - 1) / jd->vmax;
+		pc->bx0 = (x0 * pc->h / jd->hmax) / 8;
+		pc->bx1 = ((x1 * pc->h + jd->hmax - 1) / jd->hmax + 7) / 8;
+		pc->stride = pc->bw * 8;
+		pc->pix = malloc(pc->stride * pc->v * 8);
+		if (!pc->pix)
+			return "Can't allocate decode buffer for JPG data\n";
+		if (jd->buffered) {
+			size_t size = (size_t)pc->bw * pc->bh;
+
+			if (size > SIZE_MAX / (64 * sizeof(short)))
+				return "JPG image too large\n";
+			size *= 64 * sizeof(short);
+			pc->coef = malloc(size);
+			if (!pc->coef)
+				return "Can't allocate coefficient buffer for progressive JPG\n";
+			memset(pc->coef, 0, size);
+		}
+	}
+
+	if (jd->ncomp == 3) {
+		jd->rgb = malloc(jd->hres * 6);
+		if (!jd->rgb)
+			return "Can't allocate decode buffer for JPG data\n";
+		for (i = 0; i < 3; i++)
+			jd->up[i] = jd->rgb + jd->hres * (3 + i);
+	}
+
+	return NULL;
+}
+
+/* Free all buffers of the decoder */
+static void jpg_free(jpgdec_t *jd)
+{
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		free(jd->comp[i].pix);
+		free(jd->comp[i].coef);
+	}
+	free(jd->rgb);
+	free(jd);
+}
+
+/* Decode one block of a scan to the coefficient buffer */
+static int jpg_decode_coef(jpgdec_t *jd, jpgcomp_t *pc, short *blk)
+{
+	if (!jd->progressive)
+		return jpg_decode_block(jd, pc, blk);
+	if (!jd->ss) {
+		if (jd->ah)
+			return jpg_dc_refine(jd, blk);
+		return jpg_dc_first(jd, pc, blk);
+	}
+	if (jd->ah)
+		return jpg_ac_refine(jd, pc, blk);
+
+	return jpg_ac_first(jd, pc, blk);
+}
+
+/* Decode a full scan to the coefficient buffers */
+static const char *jpg_decode_scan(jpgdec_t *jd)
+{
+	int x, y, bx, by;
+
+	if (jd->ns == 1) {
+		/* Non-interleaved: each MCU is one block of the component,
+		   blocks outside of the component size are not coded */
+		jpgcomp_t *pc = jd->scomp[0];
+		int w = (pc->xsize + 7) / 8;
+		int h = (pc->ysize + 7) / 8;
+
+		for (by = 0; by < h; by++) {
+			short *blk = pc->coef + by * pc->bw * 64;
+
+			for (bx = 0; bx < w; bx++, blk += 64) {
+				if (jpg_check_restart(jd)
+				    || jpg_decode_coef(jd, pc, blk))
+					return "Corrupt JPG data\n";
+			}
+			WATCHDOG_RESET();
+		}
+		return NULL;
+	}
+
+	/* Interleaved: each MCU has h x v blocks of each component */
+	for (y = 0; y < jd->mcuy; y++) {
+		for (x = 0; x < jd->mcux; x++) {
+			int i;
+
+			if (jpg_check_restart(jd))
+				return "Corrupt JPG data\n";
+			for (i = 0; i < jd->ns; i++) {
+				jpgcomp_t *pc = jd->scomp[i];
+
+				for (by = 0; by < pc->v; by++) {
+					short *blk = pc->coef;
+
+					blk += (y * pc->v + by) * pc->bw * 64;
+					blk += x * pc->h * 64;
+					for (bx = 0; bx < pc->h; bx++) {
+						if (jpg_decode_coef(jd, pc,
+								    blk))
+							return "Corrupt JPG data\n";
+						blk += 64;
+					}
+				}
+			}
+		}
+		WATCHDOG_RESET();
+	}
+
+	return NULL;
+}
+
+/* Decode the next MCU row of a sequential scan directly to the samples */
+static const char *jpg_decode_mcurow(jpgdec_t *jd)
+{
+	int x, i, bx, by;
+
+	for (x = 0; x < jd->mcux; x++) {
+		if (jpg_check_restart(jd))
+			return "Corrupt JPG data\n";
+		for (i = 0; i < jd->ns; i++) {
+			jpgcomp_t *pc = jd->scomp[i];
+
+			for (by = 0; by < pc->v; by++) {
+				u_char *out = pc->pix + by * 8 * pc->stride;
+
+				for (bx = x * pc->h; bx < (x + 1) * pc->h; bx++) {
+					if (jpg_decode_block(jd, pc, jd->blk))
+						return "Corrupt JPG data\n";
+
+					/* Skip IDCT of invisible blocks */
+					if ((bx < pc->bx0) || (bx >= pc->bx1))
+						continue;
+					jpg_idct(jd->blk, jd->qt[pc->tq],
+						 out + bx * 8, pc->stride);
+				}
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* Convert the coefficients of MCU row y to samples */
+static void jpg_idct_mcurow(jpgdec_t *jd, int y)
+{
+	int i, bx, by;
+
+	for (i = 0; i < jd->ncomp; i++) {
+		jpgcomp_t *pc = &jd->comp[i];
+
+		for (by = 0; by < pc->v; by++) {
+			short *blk = pc->coef;
+			u_char *out = pc->pix + by * 8 * pc->stride;
+
+			blk += (y * pc->v + by) * pc->bw * 64;
+			for (bx = pc->bx0; bx < pc->bx1; bx++) {
+				jpg_idct(blk + bx * 64, jd->qt[pc->tq],
+					 out + bx * 8, pc->stride);
+			}
+		}
+	}
+}
+
+/* Get row y (within the MCU row) of a component, upsampled to the full image
+   width if the component is subsampled horizontally */
+static u_char *jpg_sample_row(jpgdec_t *jd, jpgcomp_t *pc, int y, u_char *up)
+{
+	u_char *src = pc->pix + (y * pc->v / jd->vmax) * pc->stride;
+	int x;
+
+	if (pc->h == jd->hmax)
+		return src;
+
+	if (pc->h * 2 == jd->hmax) {
+		for (x = jd->x0; x < jd->x1; x++)
+			up[x] = src[x >> 1];
+	} else {
+		for (x = jd->x0; x < jd->x1; x++)
+			up[x] = src[x * pc->h / jd->hmax];
+	}
+
+	return up;
+}
+
+/* Convert row y (within the MCU row) from YCbCr to RGB; we use 16 bit fixed
+   point values for the JFIF conversion factors */
+static u_char *jpg_color_row(jpgdec_t *jd, int y)
+{
+	u_char *py, *pcb, *pcr;
+	u_char *prgb;
+	int x;
+
+	py = jpg_sample_row(jd, &jd->comp[0], y, jd->up[0]);
+	if (jd->ncomp == 1)
+		return py;
+
+	pcb = jpg_sample_row(jd, &jd->comp[1], y, jd->up[1]);
+	pcr = jpg_sample_row(jd, &jd->comp[2], y, jd->up[2]);
+	prgb = jd->rgb + jd->x0 * 3;
+	for (x = jd->x0; x < jd->x1; x++) {
+		int lum = (py[x] << 16) + 32768;
+		int cb = pcb[x] - 128;
+		int cr = pcr[x] - 128;
+
+		*prgb++ = jpg_clamp((lum + 91881 * cr) >> 16);
+		*prgb++ = jpg_clamp((lum - 22554 * cb - 46802 * cr) >> 16);
+		*prgb++ = jpg_clamp((lum + 116130 * cb) >> 16);
+	}
+
+	return jd->rgb;
+}
+
+/* Draw all image rows of MCU row mcurow; return 1 if bottom of image or
+   screen is reached */
+static int jpg_draw_mcurow(jpgdec_t *jd, imginfo_t *pii,
+			   draw_row_func_t draw_row, int mcurow)
+{
+	int rows = jd->vmax * 8;
+	int rowpos = jd->x0 * ((jd->ncomp == 1) ? 1 : 3);
+	int i;
+
+	if (rows > jd->vres - mcurow * rows)
+		rows = jd->vres - mcurow * rows;
+
+	for (i = 0; i < rows; i++) {
+		u_char *prow = NULL;
+
+		/* If row is in framebuffer range, draw it */
+		do {
+			XYPOS y = pii->y + pii->ypix;
+			if (y >= 0) {
+				u_long fbuf;
+
+				if (!prow)
+					prow = jpg_color_row(jd, i);
+				fbuf = y*pii->pwi->linelen;
+				fbuf += pii->fbuf;
+				pii->rowshift = 8;
+				pii->prow = prow + rowpos;
+				draw_row(pii, (COLOR32 *)fbuf);
+			}
+			if (++pii->ypix >= pii->yend)
+				return 1;
+		} while (pii->ypix % pii->multiheight);
+		WATCHDOG_RESET();
+	}
+
+	return 0;
+}
+
+
 /************************************************************************/
 /* Exported functions							*/
 /************************************************************************/
 
-/* Draw JPG image */
+/* Draw JPG image. A JPG image consists of a sequence of marker segments.
+   Each marker is 0xFF followed by a marker code; most markers are followed
+   by a big endian 16 bit length and the segment data. The frame header
+   (SOFn) tells the image size and the sampling factors of the components,
+   DQT and DHT define quantization and Huffman tables. Each scan header (SOS)
+   is followed by the Huffman coded data of 8x8 DCT blocks, grouped in
+   Minimum Coded Units (MCU). Subsampled color components have less blocks
+   in each MCU than the luminance component.
+
+   Sequential images are decoded one MCU row at a time. So we only need a
+   buffer for the samples of one MCU row (8 or 16 image rows) and can draw
+   the rows immediately. Progressive images spread the coefficients over
+   several scans. So we have to keep all coefficients in memory until the
+   last scan is done. This needs about 2 bytes per sample, e.g. 6 MB for a
+   1920x1080 image with 4:2:0 subsampling, so better use sequential images
+   for large splash screens.
+
+   The chroma components are upsampled by replication; this is sufficient
+   for logos and splash screens and much faster than interpolation. We only
+   support 8-bit YCbCr (JFIF) and grayscale images with Huffman coding,
+   i.e. no arithmetic coding, no lossless and no hierarchical mode. */
 const char *draw_jpg(imginfo_t *pii, u_long addr)
 {
-	/* TODO: add JPG support; don't forget to trigger the watchdog with
-	   WATCHDOG_RESET() after each row. */
-	return "JPG images not yet supported";
+	jpgdec_t *jd;
+	const char *errmsg;
+	u_char m;
+	int y;
+	int x0, x1;
+	draw_row_func_t draw_row;	  /* Draw bitmap row */
+
+	static const draw_row_func_t draw_row_tab[][2] = {
+#ifdef CONFIG_CMD_DRAW
+		{
+			/* ATTR_ALPHA = 0 */
+			draw_ll_row_PAL8,
+			draw_ll_row_RGB
+		},
+#endif
+#ifdef CONFIG_CMD_ADRAW
+		{
+			/* ATTR_ALPHA = 1 */
+			adraw_ll_row_PAL8,
+			adraw_ll_row_RGB
+		}
+#endif
+	};
+
+	jd = malloc(sizeof(jpgdec_t));
+	if (!jd)
+		return "Can't allocate JPG decoder\n";
+	memset(jd, 0, sizeof(jpgdec_t));
+
+	/* Read all tables up to the first scan; no access beyond EOI */
+	jd->p = (u_char *)addr;
+	jd->end = (u_char *)scan_jpg(addr);
+	if (!jd->end) {
+		errmsg = "Invalid JPG data\n";
+		goto DONE;
+	}
+	errmsg = jpg_markers(jd, &m);
+	if (!errmsg && (m != M_SOS))
+		errmsg = "No JPG image data\n";
+	if (errmsg)
+		goto DONE;
+
+	/* Only decode the visible columns */
+	x0 = pii->xpix / pii->multiwidth;
+	x1 = (pii->xend + pii->multiwidth - 1) / pii->multiwidth;
+	if (x1 > jd->hres)
+		x1 = jd->hres;
+	errmsg = jpg_setup(jd, x0, x1);
+	if (errmsg)
+		goto DONE;
+
+	/* Determine the correct draw_row function */
+#if defined(CONFIG_CMD_DRAW) && defined(CONFIG_CMD_ADRAW)
+	draw_row = draw_row_tab[pii->applyalpha][jd->ncomp == 3];
+#else
+	draw_row = draw_row_tab[0][jd->ncomp == 3];
+#endif
+
+	/* Grayscale images are drawn via a gray gradient palette */
+	if (jd->ncomp == 1) {
+		const wininfo_t *pwi = pii->pwi;
+		u_int i;
+
+		pii->rowmask = 0xFF;
+		pii->rowbitdepth = 8;
+		pii->palette = palette;
+		for (i = 0; i < 256; i++) {
+			RGBA rgba = (i << 24) | (i << 16) | (i << 8) | 0xFF;
+
+			if (!pii->applyalpha)
+				rgba = (RGBA)pwi->ppi->rgba2col(pwi, rgba);
+			palette[i] = rgba;
+		}
+	}
+
+	WATCHDOG_RESET();
+
+	if (!jd->buffered) {
+		/* Sequential: decode and draw MCU row by MCU row */
+		for (y = 0; y < jd->mcuy; y++) {
+			errmsg = jpg_decode_mcurow(jd);
+			if (errmsg || jpg_draw_mcurow(jd, pii, draw_row, y))
+				break;
+		}
+		goto DONE;
+	}
+
+	/* Progressive: decode all scans, then draw MCU row by MCU row */
+	do {
+		errmsg = jpg_decode_scan(jd);
+		if (!errmsg)
+			errmsg = jpg_markers(jd, &m);
+	} while (!errmsg && (m == M_SOS));
+	for (y = 0; !errmsg && (y < jd->mcuy); y++) {
+		jpg_idct_mcurow(jd, y);
+		if (jpg_draw_mcurow(jd, pii, draw_row, y))
+			break;
+	}
+
+DONE:
+	jpg_free(jd);
+
+	return errmsg;
 }
 
 
 /* Get a bminfo structure with JPG bitmap information */
 int get_bminfo_jpg(bminfo_t *pbi, u_long addr)
 {
-	if (1)
+	u_char *p = (u_char *)addr;
+	u_char m;
+
+	/* Check for JPG image; a JPG image starts with an SOI marker that is
+	   immediately followed by another marker */
+	if ((p[0] != 0xFF) || (p[1] != M_SOI) || (p[2] != 0xFF))
 		return 0;
 
-	/* TODO: add JPG support */
+	/* Search the frame header; it has the following structure:
+	     Offset 0: segment length (2 bytes)
+	     Offset 2: sample precision (1 byte)
+	     Offset 3: height (2 bytes)
+	     Offset 5: width (2 bytes)
+	     Offset 7: number of components (1 byte)
+	     Offset 8: component specifications (3 bytes each) */
+	p += 2;
+	for (;;) {
+		if (*p != 0xFF)
+			return 0;
+		while (*p == 0xFF)
+			p++;
+		m = *p++;
+		if (jpg_is_sof(m))
+			break;
+		if ((m == M_SOS) || (m == M_EOI))
+			return 0;
+		p += get_be16(p);
+	}
+
+	pbi->type = BT_JPG;
+	if (p[7] == 1)
+		pbi->colortype = CT_GRAY;
+	else if (p[7] == 3)
+		pbi->colortype = CT_TRUECOL;
+	else
+		pbi->colortype = CT_UNKNOWN;
+	pbi->bitdepth = p[2];
+	pbi->flags = BF_COMPRESSED | ((m == M_SOF2) ? BF_INTERLACED : 0);
+	pbi->hres = (XYPOS)get_be16(p+5);
+	pbi->vres = (XYPOS)get_be16(p+3);
+
 	return 1;
 }
 
@@ -62,11 +1298,44 @@ int get_bminfo_jpg(bminfo_t *pbi, u_long addr)
 /* Scan integrity of a JPG bitmap and return end address */
 u_long scan_jpg(u_long addr)
 {
-	if (1)
+	u_char *p = (u_char *)addr;
+
+	/* Check for JPG image */
+	if ((p[0] != 0xFF) || (p[1] != M_SOI) || (p[2] != 0xFF))
 		return 0;
 
-	/* TODO: Add support for scanning a JPG bitmap */
-	return addr;
+	/* Read marker segments until EOI marker is encountered */
+	p += 2;
+	for (;;) {
+		u_char m;
+
+		/* Check for valid marker, skip fill bytes */
+		if (*p != 0xFF)
+			return 0;
+		while (*p == 0xFF)
+			p++;
+		m = *p++;
+		if (m == M_EOI)
+			break;
+		if ((m < M_SOF0) || (m == M_SOI)
+		    || ((m >= M_RST0) && (m <= M_RST7)))
+			return 0;	  /* Invalid marker */
+
+		/* Skip segment */
+		if (get_be16(p) < 2)
+			return 0;
+		p += get_be16(p);
+		if (m != M_SOS)
+			continue;
+
+		/* Skip entropy coded data up to the next marker; stuffed
+		   zero bytes and RSTn markers belong to the data */
+		while ((p[0] != 0xFF) || !p[1] || (p[1] == 0xFF)
+		       || ((p[1] >= M_RST0) && (p[1] <= M_RST7)))
+			p++;
+	}
+
+	return (u_long)p;
 }
 
 #endif /* CONFIG_XLCD_DRAW & XLCD_DRAW_BITMAP */
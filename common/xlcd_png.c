@@ -84,13 +84,16 @@ static u_short get_be16(u_char *p)
 	return (p[0] << 8) | p[1];
 }
 
-/* Special so-called paeth predictor for PNG line filtering */
-static u_char paeth(u_char a, u_char b, u_char c)
+/* Special so-called paeth predictor for PNG line filtering; a is the left,
+   b the upper and c the upper left byte. Instead of computing p = a + b - c
+   and the distances of p to a, b and c, we can compute the distances
+   directly: p - a = b - c, p - b = a - c and p - c = (b - c) + (a - c). */
+static inline u_char paeth(u_char a, u_char b, u_char c)
 {
-	int p = a + b - c;
-	int pa = p - a;
-	int pb = p - b;
-	int pc = p - c;
+	int pa = b - c;
+	int pb = a - c;
+	int pc = pa + pb;
+
 	if (pa < 0)
 		pa = -pa;
 	if (pb < 0)
@@ -105,6 +108,92 @@ static u_char paeth(u_char a, u_char b, u_char c)
 	return c;
 }
 
+/* Add the four bytes of two words without carry from byte to byte */
+static inline u_int add_bytes(u_int a, u_int b)
+{
+	return ((a & 0x7F7F7F7F) + (b & 0x7F7F7F7F)) ^ ((a ^ b) & 0x80808080);
+}
+
+/* Compute the average of the four bytes of two words (rounded down) */
+static inline u_int avg_bytes(u_int a, u_int b)
+{
+	return (a & b) + (((a ^ b) >> 1) & 0x7F7F7F7F);
+}
+
+/* Undo the PNG filter of a row; pc is the current row, pp the previous row,
+   both are word aligned. Filters that work on the whole row (up) or on 4
+   byte pixels (sub, average) are done on full words, i.e. four bytes in
+   one go. Paeth is done pixel by pixel, but for 3 and 4 byte pixels with
+   all channels in one loop iteration. */
+static void png_unfilter(u_char filtertype, u_char *pc, u_char *pp,
+			 u_int rowlen, u_int fsize)
+{
+	u_int *pcw = (u_int *)pc;
+	u_int *ppw = (u_int *)pp;
+	u_int words = (rowlen + 3) / 4;
+	u_int left = 0;
+	u_int i;
+
+	switch (filtertype) {
+	case 0:				  /* none */
+		break;
+
+	case 1:				  /* sub */
+		if (fsize == 4) {
+			for (i = 0; i < words; i++) {
+				left = add_bytes(pcw[i], left);
+				pcw[i] = left;
+			}
+			break;
+		}
+		for (i = fsize; i < rowlen; i++)
+			pc[i] += pc[i-fsize];
+		break;
+
+	case 2:				  /* up */
+		for (i = 0; i < words; i++)
+			pcw[i] = add_bytes(pcw[i], ppw[i]);
+		break;
+
+	case 3:				  /* average */
+		if (fsize == 4) {
+			for (i = 0; i < words; i++) {
+				left = add_bytes(pcw[i], avg_bytes(left, ppw[i]));
+				pcw[i] = left;
+			}
+			break;
+		}
+		for (i = 0; i < fsize; i++)
+			pc[i] += pp[i]/2;
+		for (; i < rowlen; i++)
+			pc[i] += (pc[i-fsize] + pp[i])/2;
+		break;
+
+	case 4:				  /* paeth */
+		for (i = 0; i < fsize; i++)
+			pc[i] += pp[i];	  /* paeth(0, pp[i], 0) */
+		if (fsize == 3) {
+			for (; i < rowlen; i += 3) {
+				pc[i] += paeth(pc[i-3], pp[i], pp[i-3]);
+				pc[i+1] += paeth(pc[i-2], pp[i+1], pp[i-2]);
+				pc[i+2] += paeth(pc[i-1], pp[i+2], pp[i-1]);
+			}
+		} else if (fsize == 4) {
+			for (; i < rowlen; i += 4) {
+				pc[i] += paeth(pc[i-4], pp[i], pp[i-4]);
+				pc[i+1] += paeth(pc[i-3], pp[i+1], pp[i-3]);
+				pc[i+2] += paeth(pc[i-2], pp[i+2], pp[i-2]);
+				pc[i+3] += paeth(pc[i-1], pp[i+3], pp[i-1]);
+			}
+		} else {
+			for (; i < rowlen; i++)
+				pc[i] += paeth(pc[i-fsize], pp[i],
+					       pp[i-fsize]);
+		}
+		break;
+	}
+}
+
 
 /************************************************************************/
 /* Exported functions							*/
@@ -145,6 +234,7 @@ const char *draw_png(imginfo_t *pii, u_long addr)
 	u_int pixelsize;		  /* Size of one full pixel (bits) */
 	u_int fsize;			  /* Size of one filter unit */
 	u_int rowlen;
+	u_int rowsize;			  /* Size of one row in buffer */
 	int rowpos;
 	int palconverted = 1;
 	char *errmsg = NULL;
@@ -207,8 +297,11 @@ const char *draw_png(imginfo_t *pii, u_long addr)
 	rowlen = (pii->bi.hres * pixelsize + 7) / 8; /* round to bytes */
 
 	/* Allocate row buffer for decoding two rows of the bitmap; we need
-	   one additional byte per row for the filter type */
-	prow = malloc(2*rowlen+2);
+	   one additional byte per row for the filter type. The filter type is
+	   stored at offset 3 of each row, so that the row data itself is word
+	   aligned and the filters can work on full words. */
+	rowsize = ((rowlen + 3) & ~3) + 4;
+	prow = malloc(2*rowsize);
 	if (!prow)
 		return "Can't allocate decode buffer for PNG data";
 
@@ -257,8 +350,8 @@ const char *draw_png(imginfo_t *pii, u_long addr)
 	}
 
 	/* Fill reference row (for UP and PAETH filter) with 0 */
-	current = rowlen + 1;
-	memset(prow, 0, rowlen+1);
+	current = rowsize + 3;
+	memset(prow, 0, 2*rowsize);
 
 	/* Init zlib decompression */
 	zs.zalloc = zalloc;
@@ -392,46 +485,13 @@ const char *draw_png(imginfo_t *pii, u_long addr)
 				break;
 			}
 			if (zs.avail_out == 0) {
-				int i;
-
 				/* Current row */
 				u_char *pc = prow + current;
 				/* Previous row */
-				u_char *pp = prow + (rowlen+2) - current;
-				u_char filtertype = *pc++;
+				u_char *pp = prow + (rowsize + 6) - current;
 
 				/* Apply the filter on this row */
-				switch (filtertype) {
-				case 0:			  /* none */
-					break;
-
-				case 1:			  /* sub */
-					for (i=fsize; i<rowlen; i++)
-						pc[i] += pc[i-fsize];
-					break;
-
-				case 2:			  /* up */
-					for (i=0; i<rowlen; i++)
-						pc[i] += pp[i];
-					break;
-
-				case 3:			  /* average */
-					for (i=0; i<fsize; i++)
-						pc[i] += pp[i]/2;
-					for (; i<rowlen; i++)
-						pc[i] += (pc[i-fsize]+pp[i])/2;
-					break;
-
-				case 4:			  /* paeth */
-					for (i=0; i<fsize; i++)
-						//pc[i] += paeth(0, pp[i], 0);
-						pc[i] += pp[i];
-					for (; i<rowlen; i++)
-						pc[i] += paeth(pc[i-fsize],
-							       pp[i],
-							       pp[i-fsize]);
-					break;
-				}
+				png_unfilter(*pc, pc + 1, pp + 1, rowlen, fsize);
 
 				/* If row is in framebuffer range, draw it */
 				do {
@@ -450,8 +510,8 @@ const char *draw_png(imginfo_t *pii, u_long addr)
 						goto DONE;
 				} while (pii->ypix % pii->multiheight);
 
-				/* Toggle current between 0 and rowlen+1 */
-				current = rowlen + 1 - current;
+				/* Toggle current between 3 and rowsize+3 */
+				current = rowsize + 6 - current;
 				zs.next_out = prow + current;
 				zs.avail_out = rowlen + 1;
 			}
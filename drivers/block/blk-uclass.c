@@ -9,7 +9,10 @@
 #include <dm.h>
 #include <log.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <part.h>
+#include <time.h>
+#include <watchdog.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/uclass-internal.h>
@@ -432,19 +435,66 @@ int blk_get_device(int if_type, int devnum, struct udevice **devp)
 	return device_probe(*devp);
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/* Queue of asynchronous requests, uclass-private data of a block device */
+struct blk_async_queue {
+	struct list_head waiting;	/* Not yet submitted to the driver */
+	struct list_head active;	/* Submitted to the driver */
+	int count;			/* Number of pending requests */
+	int writes;			/* Number of pending write requests */
+	uint wgen;			/* Changed by every write start/end */
+};
+
+#define BLK_REQ_TIMEOUT_MS	10000
+
+static void blk_async_drain(struct udevice *dev);
+#else
+static inline void blk_async_drain(struct udevice *dev) {}
+#endif
+
 unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			lbaint_t blkcnt, void *buffer)
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
 	ulong blks_read;
+	lbaint_t ra;
+	void *buf;
 
 	if (!ops->read)
 		return -ENOSYS;
 
+	blk_async_drain(dev);
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
 			  start, blkcnt, block_dev->blksz, buffer))
 		return blkcnt;
+
+	ra = 0;
+	if (start + blkcnt < block_dev->lba)
+		ra = blkcache_readahead(block_dev->if_type, block_dev->devnum,
+					start, blkcnt,
+					block_dev->lba - start - blkcnt);
+	if (ra) {
+		/*
+		 * Read more blocks than requested so that they get cached. The
+		 * driver may DMA into the buffer, so it must be cache aligned.
+		 */
+		buf = malloc_cache_aligned((blkcnt + ra) * block_dev->blksz);
+		if (buf) {
+			blks_read = ops->read(dev, start, blkcnt + ra, buf);
+			if (blks_read == blkcnt + ra) {
+				blkcache_fill(block_dev->if_type,
+					      block_dev->devnum, start,
+					      blkcnt + ra, block_dev->blksz,
+					      buf);
+				memcpy(buffer, buf, blkcnt * block_dev->blksz);
+				free(buf);
+				return blkcnt;
+			}
+			free(buf);
+		}
+	}
+
 	blks_read = ops->read(dev, start, blkcnt, buffer);
 	if (blks_read == blkcnt)
 		blkcache_fill(block_dev->if_type, block_dev->devnum,
@@ -462,6 +512,7 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 	if (!ops->write)
 		return -ENOSYS;
 
+	blk_async_drain(dev);
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
 	return ops->write(dev, start, blkcnt, buffer);
 }
@@ -475,10 +526,191 @@ unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 	if (!ops->erase)
 		return -ENOSYS;
 
+	blk_async_drain(dev);
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
 	return ops->erase(dev, start, blkcnt);
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/* Do a request synchronously */
+static long blk_req_sync(struct udevice *dev, struct blk_req *req)
+{
+	const struct blk_ops *ops = blk_get_ops(dev);
+
+	if (req->write)
+		return ops->write(dev, req->start, req->blkcnt, req->buffer);
+
+	return ops->read(dev, req->start, req->blkcnt, req->buffer);
+}
+
+static void blk_req_complete(struct blk_async_queue *q, struct blk_req *req,
+			     long result)
+{
+	struct blk_desc *desc = req->desc;
+
+	list_del(&req->node);
+	q->count--;
+	req->result = result;
+	if (req->write) {
+		/* Reads may have filled the cache while the write was active */
+		q->writes--;
+		q->wgen++;
+		blkcache_invalidate(desc->if_type, desc->devnum);
+	} else if ((result == req->blkcnt) && !q->writes
+		   && (req->wgen == q->wgen)) {
+		/* Only cache the data if no write overlapped with the read */
+		blkcache_fill(desc->if_type, desc->devnum, req->start,
+			      req->blkcnt, desc->blksz, req->buffer);
+	}
+}
+
+/* Retire completed requests and hand waiting requests to the driver */
+static void blk_async_run(struct udevice *dev, struct blk_async_queue *q)
+{
+	const struct blk_ops *ops = blk_get_ops(dev);
+	struct blk_req *req, *n;
+	long result;
+	int ret;
+
+	list_for_each_entry_safe(req, n, &q->active, node) {
+		result = ops->poll(dev, req);
+		if (result != -EINPROGRESS)
+			blk_req_complete(q, req, result);
+	}
+
+	list_for_each_entry_safe(req, n, &q->waiting, node) {
+		ret = ops->submit ? ops->submit(dev, req) : -ENOSYS;
+		if (!ret) {
+			list_move_tail(&req->node, &q->active);
+			continue;
+		}
+		if (ret == -EBUSY)
+			break;
+		if (ret == -ENOSYS) {
+			/* Do not overtake requests that are still active */
+			if (!list_empty(&q->active))
+				break;
+			result = blk_req_sync(dev, req);
+		} else {
+			result = ret;
+		}
+		blk_req_complete(q, req, result);
+	}
+}
+
+static void blk_async_drain(struct udevice *dev)
+{
+	struct blk_async_queue *q = dev_get_uclass_priv(dev);
+
+	while (q && q->count)
+		blk_async_run(dev, q);
+}
+
+static int blk_async_submit(struct blk_desc *block_dev, struct blk_req *req)
+{
+	struct udevice *dev = block_dev->bdev;
+	struct blk_async_queue *q;
+	int ret;
+
+	ret = device_probe(dev);
+	if (ret)
+		return ret;
+
+	q = dev_get_uclass_priv(dev);
+	if (q->count >= BLK_ASYNC_QUEUE_DEPTH) {
+		blk_async_run(dev, q);
+		if (q->count >= BLK_ASYNC_QUEUE_DEPTH)
+			return -EBUSY;
+	}
+
+	req->result = -EINPROGRESS;
+	req->priv = 0;
+	if (req->write) {
+		q->writes++;
+		q->wgen++;
+	}
+	req->wgen = q->wgen;
+	list_add_tail(&req->node, &q->waiting);
+	q->count++;
+	blk_async_run(dev, q);
+
+	return 0;
+}
+
+int blk_dread_async(struct blk_desc *block_dev, lbaint_t start,
+		    lbaint_t blkcnt, void *buffer, struct blk_req *req)
+{
+	const struct blk_ops *ops = blk_get_ops(block_dev->bdev);
+
+	if (!ops->read)
+		return -ENOSYS;
+
+	req->desc = block_dev;
+	req->start = start;
+	req->blkcnt = blkcnt;
+	req->buffer = buffer;
+	req->write = false;
+
+	if (blkcache_read(block_dev->if_type, block_dev->devnum,
+			  start, blkcnt, block_dev->blksz, buffer)) {
+		req->result = blkcnt;
+		return 0;
+	}
+
+	return blk_async_submit(block_dev, req);
+}
+
+int blk_dwrite_async(struct blk_desc *block_dev, lbaint_t start,
+		     lbaint_t blkcnt, const void *buffer, struct blk_req *req)
+{
+	const struct blk_ops *ops = blk_get_ops(block_dev->bdev);
+
+	if (!ops->write)
+		return -ENOSYS;
+
+	req->desc = block_dev;
+	req->start = start;
+	req->blkcnt = blkcnt;
+	req->buffer = (void *)buffer;
+	req->write = true;
+
+	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+
+	return blk_async_submit(block_dev, req);
+}
+
+long blk_req_poll(struct blk_req *req)
+{
+	struct udevice *dev = req->desc->bdev;
+
+	if (req->result == -EINPROGRESS)
+		blk_async_run(dev, dev_get_uclass_priv(dev));
+
+	return req->result;
+}
+
+long blk_req_wait(struct blk_req *req)
+{
+	struct udevice *dev = req->desc->bdev;
+	ulong start = get_timer(0);
+	long result;
+
+	for (;;) {
+		result = blk_req_poll(req);
+		if (result != -EINPROGRESS)
+			return result;
+		if (get_timer(start) > BLK_REQ_TIMEOUT_MS)
+			break;
+		WATCHDOG_RESET();
+	}
+
+	log_err("%s: Request timed out\n", dev->name);
+	blk_req_complete(dev_get_uclass_priv(dev), req, -ETIMEDOUT);
+
+	return -ETIMEDOUT;
+}
+#endif
+
 int blk_get_from_parent(struct udevice *parent, struct udevice **devp)
 {
 	struct udevice *dev;
@@ -646,6 +878,12 @@ int blk_unbind_all(int if_type)
 
 static int blk_post_probe(struct udevice *dev)
 {
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct blk_async_queue *q = dev_get_uclass_priv(dev);
+
+	INIT_LIST_HEAD(&q->waiting);
+	INIT_LIST_HEAD(&q->active);
+#endif
 	if (IS_ENABLED(CONFIG_PARTITIONS) &&
 	    IS_ENABLED(CONFIG_HAVE_BLOCK_DEVICE)) {
 		struct blk_desc *desc = dev_get_uclass_plat(dev);
@@ -661,4 +899,7 @@ UCLASS_DRIVER(blk) = {
 	.name		= "blk",
 	.post_probe	= blk_post_probe,
 	.per_device_plat_auto	= sizeof(struct blk_desc),
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.per_device_auto	= sizeof(struct blk_async_queue),
+#endif
 };
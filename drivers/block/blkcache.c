@@ -6,6 +6,7 @@
  */
 #include <common.h>
 #include <blk.h>
+#include <errno.h>
 #include <log.h>
 #include <malloc.h>
 #include <part.h>
@@ -17,21 +18,45 @@
 DECLARE_GLOBAL_DATA_PTR;
 #endif
 
-struct block_cache_node {
+/*
+ * Cached extents never cross a span boundary, so each extent lives in
+ * exactly one hash bucket and a lookup only has to walk one short chain.
+ * Larger fills are split into several extents.
+ */
+#define BLKCACHE_SPAN_SHIFT	6	/* 64 blocks */
+#define BLKCACHE_HASH_SIZE	256	/* Must be a power of 2 */
+
+/* Default limits */
+#define BLKCACHE_MAX_BLOCKS	32
+#define BLKCACHE_MAX_BYTES	(512 * 1024)
+
+/* Per-device state: statistics and sequential read-ahead detection */
+struct block_cache_dev {
 	struct list_head lh;
 	int iftype;
 	int devnum;
+	lbaint_t next;			/* Expected start of next read */
+	lbaint_t window;		/* Current read-ahead in blocks */
+	struct block_cache_dev_stats stats;
+};
+
+struct block_cache_node {
+	struct list_head lh;		/* LRU list, most recent first */
+	struct hlist_node hn;		/* Chain in hash bucket */
+	struct block_cache_dev *dev;
 	lbaint_t start;
 	lbaint_t blkcnt;
 	unsigned long blksz;
-	char *cache;
+	char cache[];
 };
 
 static LIST_HEAD(block_cache);
+static LIST_HEAD(block_cache_devs);
+static struct hlist_head block_cache_hash[BLKCACHE_HASH_SIZE];
 
 static struct block_cache_stats _stats = {
-	.max_blocks_per_entry = 8,
-	.max_entries = 32
+	.max_blocks_per_entry = BLKCACHE_MAX_BLOCKS,
+	.max_bytes = BLKCACHE_MAX_BYTES,
 };
 
 #ifdef CONFIG_NEEDS_MANUAL_RELOC
@@ -42,19 +67,69 @@ int blkcache_init(void)
 	head->next = (uintptr_t)head->next + gd->reloc_off;
 	head->prev = (uintptr_t)head->prev + gd->reloc_off;
 
+	head = &block_cache_devs;
+	head->next = (uintptr_t)head->next + gd->reloc_off;
+	head->prev = (uintptr_t)head->prev + gd->reloc_off;
+
 	return 0;
 }
 #endif
 
-static struct block_cache_node *cache_find(int iftype, int devnum,
+static struct hlist_head *cache_bucket(struct block_cache_dev *dev,
+				       lbaint_t start)
+{
+	unsigned long hash;
+
+	hash = (unsigned long)(start >> BLKCACHE_SPAN_SHIFT);
+	hash ^= (dev->devnum << 4) ^ (dev->iftype << 8);
+	hash ^= hash >> 8;
+
+	return &block_cache_hash[hash & (BLKCACHE_HASH_SIZE - 1)];
+}
+
+/* Number of blocks from start up to the end of its span */
+static lbaint_t cache_span_left(lbaint_t start)
+{
+	lbaint_t span = (lbaint_t)1 << BLKCACHE_SPAN_SHIFT;
+
+	return span - (start & (span - 1));
+}
+
+/* Find the device entry, optionally create it if it does not exist yet */
+static struct block_cache_dev *cache_get_dev(int iftype, int devnum,
+					     bool create)
+{
+	struct block_cache_dev *dev;
+
+	list_for_each_entry(dev, &block_cache_devs, lh) {
+		if ((dev->iftype == iftype) && (dev->devnum == devnum))
+			return dev;
+	}
+
+	if (!create)
+		return NULL;
+
+	dev = calloc(1, sizeof(*dev));
+	if (!dev)
+		return NULL;
+	dev->iftype = iftype;
+	dev->devnum = devnum;
+	dev->stats.iftype = iftype;
+	dev->stats.devnum = devnum;
+	list_add_tail(&dev->lh, &block_cache_devs);
+
+	return dev;
+}
+
+static struct block_cache_node *cache_find(struct block_cache_dev *dev,
 					   lbaint_t start, lbaint_t blkcnt,
 					   unsigned long blksz)
 {
 	struct block_cache_node *node;
+	struct hlist_node *pos;
 
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum) &&
+	hlist_for_each_entry(node, pos, cache_bucket(dev, start), hn)
+		if ((node->dev == dev) &&
 		    (node->blksz == blksz) &&
 		    (node->start <= start) &&
 		    (node->start + node->blkcnt >= start + blkcnt)) {
@@ -68,123 +143,234 @@ static struct block_cache_node *cache_find(int iftype, int devnum,
 	return 0;
 }
 
+static void cache_drop(struct block_cache_node *node)
+{
+	list_del(&node->lh);
+	hlist_del(&node->hn);
+	_stats.entries--;
+	_stats.bytes -= node->blkcnt * node->blksz;
+	free(node);
+}
+
+static void cache_insert(struct block_cache_dev *dev, lbaint_t start,
+			 lbaint_t blkcnt, unsigned long blksz,
+			 void const *buffer)
+{
+	lbaint_t bytes = blksz * blkcnt;
+	struct block_cache_node *node;
+
+	/* Evict least recently used extents until the new one fits */
+	while (_stats.bytes + bytes > _stats.max_bytes) {
+		node = list_entry(block_cache.prev, struct block_cache_node,
+				  lh);
+		debug("drop: start " LBAF ", count " LBAFU "\n",
+		      node->start, node->blkcnt);
+		node->dev->stats.evictions++;
+		_stats.evictions++;
+		cache_drop(node);
+	}
+
+	node = malloc(sizeof(*node) + bytes);
+	if (!node)
+		return;
+
+	debug("fill: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
+
+	node->dev = dev;
+	node->start = start;
+	node->blkcnt = blkcnt;
+	node->blksz = blksz;
+	memcpy(node->cache, buffer, bytes);
+	list_add(&node->lh, &block_cache);
+	hlist_add_head(&node->hn, cache_bucket(dev, start));
+	_stats.entries++;
+	_stats.bytes += bytes;
+}
+
 int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
+	struct block_cache_dev *dev;
+	struct block_cache_node *node;
+	lbaint_t pos = start;
+	lbaint_t left = blkcnt;
+	lbaint_t count;
+	char *dst = buffer;
+
+	dev = cache_get_dev(iftype, devnum, true);
+	if (!dev)
+		return 0;
+
+	/* Big reads are never cached, so do not even look */
+	if (blkcnt > _stats.max_blocks_per_entry)
+		left = 0;
+
+	while (left) {
+		count = min(left, cache_span_left(pos));
+		node = cache_find(dev, pos, count, blksz);
+		if (!node)
+			break;
+		memcpy(dst, node->cache + (pos - node->start) * blksz,
+		       blksz * count);
+		dst += blksz * count;
+		pos += count;
+		left -= count;
+	}
+
+	if (pos == start + blkcnt) {
 		debug("hit: start " LBAF ", count " LBAFU "\n",
 		      start, blkcnt);
+		/* Keep track of sequential reads that hit read-ahead data */
+		if (dev->next == start)
+			dev->next = start + blkcnt;
+		dev->stats.hits++;
 		++_stats.hits;
 		return 1;
 	}
 
 	debug("miss: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
+	dev->stats.misses++;
 	++_stats.misses;
 	return 0;
 }
 
+lbaint_t blkcache_readahead(int iftype, int devnum,
+			    lbaint_t start, lbaint_t blkcnt, lbaint_t limit)
+{
+	struct block_cache_dev *dev;
+	lbaint_t max = _stats.max_blocks_per_entry;
+	lbaint_t ra;
+
+	dev = cache_get_dev(iftype, devnum, false);
+	if (!dev)
+		return 0;
+
+	/*
+	 * A miss right where the previous read ended is a sequential access,
+	 * so double the read-ahead window; any other access resets it.
+	 */
+	if ((dev->next == start) && (blkcnt < max)) {
+		if (dev->window)
+			dev->window *= 2;
+		else
+			dev->window = blkcnt;
+		if (dev->window > max - blkcnt)
+			dev->window = max - blkcnt;
+	} else {
+		dev->window = 0;
+	}
+
+	/* Never read beyond the end of the device */
+	ra = min(dev->window, limit);
+	dev->next = start + blkcnt + ra;
+	dev->stats.readahead += ra;
+
+	return ra;
+}
+
 void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
-	struct block_cache_node *node;
+	struct block_cache_dev *dev;
+	const char *src = buffer;
+	lbaint_t count;
 
 	/* don't cache big stuff */
 	if (blkcnt > _stats.max_blocks_per_entry)
 		return;
 
-	if (_stats.max_entries == 0)
+	if (blksz * blkcnt > _stats.max_bytes)
 		return;
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
-		}
-	} else {
-		node = malloc(sizeof(*node));
-		if (!node)
-			return;
-		node->cache = 0;
-	}
+	dev = cache_get_dev(iftype, devnum, true);
+	if (!dev)
+		return;
 
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
-		}
+	while (blkcnt) {
+		count = min(blkcnt, cache_span_left(start));
+		cache_insert(dev, start, count, blksz, src);
+		src += blksz * count;
+		start += count;
+		blkcnt -= count;
 	}
-
-	debug("fill: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
-
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache_node *node, *n;
+	struct block_cache_dev *dev;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
-			--_stats.entries;
-		}
+	dev = cache_get_dev(iftype, devnum, false);
+	if (!dev)
+		return;
+
+	list_for_each_entry_safe(node, n, &block_cache, lh) {
+		if (node->dev == dev)
+			cache_drop(node);
 	}
+	dev->next = 0;
+	dev->window = 0;
 }
 
-void blkcache_configure(unsigned blocks, unsigned entries)
+void blkcache_configure(unsigned blocks, unsigned long bytes)
 {
 	struct block_cache_node *node;
+	struct block_cache_dev *dev;
+
 	if ((blocks != _stats.max_blocks_per_entry) ||
-	    (entries != _stats.max_entries)) {
+	    (bytes != _stats.max_bytes)) {
 		/* invalidate cache */
 		while (!list_empty(&block_cache)) {
-			node = (struct block_cache_node *)block_cache.next;
-			list_del(&node->lh);
-			free(node->cache);
-			free(node);
+			node = list_first_entry(&block_cache,
+						struct block_cache_node, lh);
+			cache_drop(node);
 		}
-		_stats.entries = 0;
 	}
 
 	_stats.max_blocks_per_entry = blocks;
-	_stats.max_entries = entries;
+	_stats.max_bytes = bytes;
 
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.evictions = 0;
+	list_for_each_entry(dev, &block_cache_devs, lh) {
+		memset(&dev->stats, 0, sizeof(dev->stats));
+		dev->stats.iftype = dev->iftype;
+		dev->stats.devnum = dev->devnum;
+		dev->window = 0;
+	}
+}
+
+int blkcache_dev_stats(int index, struct block_cache_dev_stats *stats)
+{
+	struct block_cache_dev *dev;
+
+	list_for_each_entry(dev, &block_cache_devs, lh) {
+		if (!index--) {
+			memcpy(stats, &dev->stats, sizeof(*stats));
+			return 0;
+		}
+	}
+
+	return -ENOENT;
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
 {
+	struct block_cache_dev *dev;
+
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.evictions = 0;
+	list_for_each_entry(dev, &block_cache_devs, lh) {
+		dev->stats.hits = 0;
+		dev->stats.misses = 0;
+		dev->stats.evictions = 0;
+		dev->stats.readahead = 0;
+	}
 }
@@ -500,16 +500,8 @@ static struct blk_desc *fastboot_mmc_get_dev(char *response)
 	return ret;
 }
 
-/**
- * fastboot_mmc_flash_write() - Write image to eMMC for fastboot
- *
- * @cmd: Named partition to write image to
- * @download_buffer: Pointer to image data
- * @download_bytes: Size of image data
- * @response: Pointer to fastboot response buffer
- */
-void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
-			      u32 download_bytes, char *response)
+static void fb_mmc_flash_write(const char *cmd, void *download_buffer,
+			       u32 download_bytes, char *response)
 {
 	struct blk_desc *dev_desc;
 	struct disk_partition info;
@@ -630,6 +622,29 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 	}
 }
 
+/**
+ * fastboot_mmc_flash_write() - Write image to eMMC for fastboot
+ *
+ * @cmd: Named partition to write image to
+ * @download_buffer: Pointer to image data
+ * @download_bytes: Size of image data
+ * @response: Pointer to fastboot response buffer
+ */
+void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
+			      u32 download_bytes, char *response)
+{
+	struct mmc *mmc;
+
+	fb_mmc_flash_write(cmd, download_buffer, download_bytes, response);
+	if (strncmp(response, "OKAY", 4))
+		return;
+
+	/* Only report success when the data has reached the medium */
+	mmc = find_mmc_device(CONFIG_FASTBOOT_FLASH_MMC_DEV);
+	if (mmc && mmc_flush_cache(mmc))
+		fastboot_fail("failed flushing device cache", response);
+}
+
 /**
  * fastboot_mmc_flash_erase() - Erase eMMC for fastboot
  *
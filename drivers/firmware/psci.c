@@ -11,6 +11,7 @@
 #include <dm.h>
 #include <irq_func.h>
 #include <log.h>
+#include <mmc.h>
 #include <dm/lists.h>
 #include <efi_loader.h>
 #include <linux/delay.h>
@@ -136,6 +137,7 @@ void __efi_runtime EFIAPI efi_reset_system(enum efi_reset_type reset_type,
 #ifdef CONFIG_PSCI_RESET
 void reset_misc(void)
 {
+	mmc_flush_caches();
 	do_psci_probe();
 	invoke_psci_fn(PSCI_0_2_FN_SYSTEM_RESET, 0, 0, 0);
 }
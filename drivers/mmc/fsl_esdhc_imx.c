@@ -131,6 +131,33 @@ struct esdhc_soc_data {
 };
 #endif
 
+#if CONFIG_IS_ENABLED(FSL_USDHC_ADMA2) && !defined(CONFIG_SYS_FSL_ESDHC_USE_PIO)
+#define ESDHC_USE_ADMA2
+
+/*
+ * ADMA2 descriptor. The uSDHC only knows 32-bit addresses here, so we can not
+ * use struct sdhci_adma_desc, which has 64-bit addresses on ARM64.
+ */
+struct esdhc_adma_desc {
+	u8 attr;
+	u8 reserved;
+	u16 len;
+	u32 addr;
+};
+
+#define ESDHC_ADMA_VALID	0x01
+#define ESDHC_ADMA_END		0x02
+#define ESDHC_ADMA_TRAN		0x20
+
+/* Keep descriptor lengths word aligned */
+#define ESDHC_ADMA_MAX_LEN	65532
+#define ESDHC_ADMA_ENTRIES	DIV_ROUND_UP(CONFIG_SYS_MMC_MAX_BLK_COUNT * \
+					     MMC_MAX_BLOCK_LEN, \
+					     ESDHC_ADMA_MAX_LEN)
+#define ESDHC_ADMA_TABLE_SZ	(ESDHC_ADMA_ENTRIES * \
+				 sizeof(struct esdhc_adma_desc))
+#endif
+
 /**
  * struct fsl_esdhc_priv
  *
@@ -154,6 +181,7 @@ struct esdhc_soc_data {
  * @signal_voltage_switch_extra_delay_ms: extra delay for IO voltage switch
  * @cd_gpio: gpio for card detection
  * @wp_gpio: gpio for write protection
+ * @adma_desc_table: ADMA2 descriptors, reused for all transfers
  */
 struct fsl_esdhc_priv {
 	struct fsl_esdhc_cfg esdhc;
@@ -185,6 +213,9 @@ struct fsl_esdhc_priv {
 	struct gpio_desc cd_gpio;
 	struct gpio_desc wp_gpio;
 #endif
+#ifdef ESDHC_USE_ADMA2
+	struct esdhc_adma_desc *adma_desc_table;
+#endif
 };
 
 /* Return the XFERTYP flags for a given command and data packet */
@@ -291,6 +322,45 @@ static void esdhc_pio_read_write(struct fsl_esdhc_priv *priv,
 }
 #endif
 
+#ifdef ESDHC_USE_ADMA2
+/* Fill the ADMA2 descriptor table for the data and switch to ADMA2 */
+static void esdhc_setup_adma(struct fsl_esdhc_priv *priv,
+			     struct mmc_data *data)
+{
+	struct fsl_esdhc *regs = (struct fsl_esdhc *)priv->esdhc.esdhc_base;
+	struct esdhc_adma_desc *desc = priv->adma_desc_table;
+	uint len = data->blocks * data->blocksize;
+	dma_addr_t addr;
+	uint cur;
+
+	if (data->flags & MMC_DATA_READ)
+		addr = virt_to_phys((void *)data->dest);
+	else
+		addr = virt_to_phys((void *)data->src);
+
+	/* The whole transfer is done with one chain, the last entry ends it */
+	do {
+		cur = min(len, (uint)ESDHC_ADMA_MAX_LEN);
+		desc->attr = ESDHC_ADMA_VALID | ESDHC_ADMA_TRAN;
+		desc->reserved = 0;
+		desc->len = cur;
+		desc->addr = lower_32_bits(addr);
+		addr += cur;
+		len -= cur;
+		if (!len)
+			desc->attr |= ESDHC_ADMA_END;
+		desc++;
+	} while (len);
+
+	flush_dcache_range((ulong)priv->adma_desc_table,
+			   ALIGN((ulong)desc, ARCH_DMA_MINALIGN));
+
+	esdhc_write32(&regs->adsaddr,
+		      lower_32_bits(virt_to_phys(priv->adma_desc_table)));
+	esdhc_clrsetbits32(&regs->proctl, PROCTL_DMAS_MASK, PROCTL_DMAS_ADMA2);
+}
+#endif
+
 static int esdhc_setup_data(struct fsl_esdhc_priv *priv, struct mmc *mmc,
 			    struct mmc_data *data)
 {
@@ -363,6 +433,11 @@ static int esdhc_setup_data(struct fsl_esdhc_priv *priv, struct mmc *mmc,
 
 	esdhc_write32(&regs->blkattr, data->blocks << 16 | data->blocksize);
 
+#ifdef ESDHC_USE_ADMA2
+	if (priv->adma_desc_table)
+		esdhc_setup_adma(priv, data);
+#endif
+
 	/* Calculate the timeout period for data transactions */
 	/*
 	 * 1)Timeout period = (2^(timeout+13)) SD Clock cycles
@@ -449,12 +524,86 @@ static inline void sd_swap_dma_buff(struct mmc_data *data)
 }
 #endif
 
+#ifndef CONFIG_SYS_FSL_ESDHC_USE_PIO
+/*
+ * Checks once whether the data transfer of a command is complete. Returns
+ * -EINPROGRESS if it is still running.
+ */
+static int esdhc_check_data(struct fsl_esdhc_priv *priv, struct mmc_cmd *cmd,
+			    struct mmc_data *data)
+{
+	struct fsl_esdhc *regs = (struct fsl_esdhc *)priv->esdhc.esdhc_base;
+	u32 flags = DATA_COMPLETE;
+	uint irqstat;
+
+	if ((cmd->cmdidx == MMC_CMD_SEND_TUNING_BLOCK) ||
+	    (cmd->cmdidx == MMC_CMD_SEND_TUNING_BLOCK_HS200))
+		flags = IRQSTAT_BRR;
+
+	irqstat = esdhc_read32(&regs->irqstat);
+
+	if (irqstat & IRQSTAT_DTOE)
+		return -ETIMEDOUT;
+
+	if (irqstat & DATA_ERR)
+		return -ECOMM;
+
+	if ((irqstat & flags) != flags)
+		return -EINPROGRESS;
+
+	/*
+	 * Need invalidate the dcache here again to avoid any
+	 * cache-fill during the DMA operations such as the
+	 * speculative pre-fetching etc.
+	 */
+	if (data->flags & MMC_DATA_READ) {
+		check_and_invalidate_dcache_range(cmd, data);
+#ifdef CONFIG_MCF5441x
+		sd_swap_dma_buff(data);
+#endif
+	}
+
+	return 0;
+}
+#endif
+
+/* Cleans up after a command, resets CMD and DATA portions on error */
+static void esdhc_end_cmd(struct fsl_esdhc_priv *priv, struct mmc_cmd *cmd,
+			  struct mmc_data *data, int err)
+{
+	struct fsl_esdhc *regs = (struct fsl_esdhc *)priv->esdhc.esdhc_base;
+
+	if (err) {
+		esdhc_write32(&regs->sysctl, esdhc_read32(&regs->sysctl) |
+			      SYSCTL_RSTC);
+		while (esdhc_read32(&regs->sysctl) & SYSCTL_RSTC)
+			;
+
+		if (data) {
+			esdhc_write32(&regs->sysctl,
+				      esdhc_read32(&regs->sysctl) |
+				      SYSCTL_RSTD);
+			while ((esdhc_read32(&regs->sysctl) & SYSCTL_RSTD))
+				;
+		}
+
+		/* If this was CMD11, then notify that power cycle is needed */
+		if (cmd->cmdidx == SD_CMD_SWITCH_UHS18V)
+			printf("CMD11 to switch to 1.8V mode failed, card requires power cycle.\n");
+	}
+
+	esdhc_write32(&regs->irqstat, -1);
+}
+
 /*
  * Sends a command out on the bus.  Takes the mmc pointer,
- * a command pointer, and an optional data pointer.
+ * a command pointer, and an optional data pointer. If async is set, return
+ * as soon as the command is accepted and leave the data transfer running;
+ * esdhc_poll_data_common() then finishes the command.
  */
 static int esdhc_send_cmd_common(struct fsl_esdhc_priv *priv, struct mmc *mmc,
-				 struct mmc_cmd *cmd, struct mmc_data *data)
+				 struct mmc_cmd *cmd, struct mmc_data *data,
+				 bool async)
 {
 	int	err = 0;
 	uint	xfertyp;
@@ -570,65 +719,36 @@ static int esdhc_send_cmd_common(struct fsl_esdhc_priv *priv, struct mmc *mmc,
 #ifdef CONFIG_SYS_FSL_ESDHC_USE_PIO
 		esdhc_pio_read_write(priv, data);
 #else
-		flags = DATA_COMPLETE;
-		if ((cmd->cmdidx == MMC_CMD_SEND_TUNING_BLOCK) ||
-		    (cmd->cmdidx == MMC_CMD_SEND_TUNING_BLOCK_HS200)) {
-			flags = IRQSTAT_BRR;
-		}
+		/* esdhc_poll_data_common() waits for the data */
+		if (async)
+			return 0;
 
 		do {
-			irqstat = esdhc_read32(&regs->irqstat);
-
-			if (irqstat & IRQSTAT_DTOE) {
-				err = -ETIMEDOUT;
-				goto out;
-			}
-
-			if (irqstat & DATA_ERR) {
-				err = -ECOMM;
-				goto out;
-			}
-		} while ((irqstat & flags) != flags);
-
-		/*
-		 * Need invalidate the dcache here again to avoid any
-		 * cache-fill during the DMA operations such as the
-		 * speculative pre-fetching etc.
-		 */
-		if (data->flags & MMC_DATA_READ) {
-			check_and_invalidate_dcache_range(cmd, data);
-#ifdef CONFIG_MCF5441x
-			sd_swap_dma_buff(data);
-#endif
-		}
+			err = esdhc_check_data(priv, cmd, data);
+		} while (err == -EINPROGRESS);
 #endif
 	}
 
 out:
-	/* Reset CMD and DATA portions on error */
-	if (err) {
-		esdhc_write32(&regs->sysctl, esdhc_read32(&regs->sysctl) |
-			      SYSCTL_RSTC);
-		while (esdhc_read32(&regs->sysctl) & SYSCTL_RSTC)
-			;
+	esdhc_end_cmd(priv, cmd, data, err);
 
-		if (data) {
-			esdhc_write32(&regs->sysctl,
-				      esdhc_read32(&regs->sysctl) |
-				      SYSCTL_RSTD);
-			while ((esdhc_read32(&regs->sysctl) & SYSCTL_RSTD))
-				;
-		}
+	return err;
+}
 
-		/* If this was CMD11, then notify that power cycle is needed */
-		if (cmd->cmdidx == SD_CMD_SWITCH_UHS18V)
-			printf("CMD11 to switch to 1.8V mode failed, card requires power cycle.\n");
-	}
+#if CONFIG_IS_ENABLED(BLK_ASYNC) && !defined(CONFIG_SYS_FSL_ESDHC_USE_PIO)
+/* Checks the data transfer of an async command and finishes it when done */
+static int esdhc_poll_data_common(struct fsl_esdhc_priv *priv,
+				  struct mmc_cmd *cmd, struct mmc_data *data)
+{
+	int err;
 
-	esdhc_write32(&regs->irqstat, -1);
+	err = esdhc_check_data(priv, cmd, data);
+	if (err != -EINPROGRESS)
+		esdhc_end_cmd(priv, cmd, data, err);
 
 	return err;
 }
+#endif
 
 static void set_sysctl(struct fsl_esdhc_priv *priv, struct mmc *mmc, uint clock)
 {
@@ -1103,6 +1223,14 @@ static int esdhc_init_common(struct fsl_esdhc_priv *priv, struct mmc *mmc)
 #else
 	/* Put the PROCTL reg back to the default */
 	esdhc_write32(&regs->proctl, PROCTL_INIT);
+
+	/*
+	 * The ROM code may have cleared the burst length enable bit. Without
+	 * it, INCR bursts on AHB are converted to single accesses on AXI,
+	 * which costs a lot of DMA performance.
+	 */
+	if (priv->esdhc.flags & ESDHC_FLAG_USDHC)
+		esdhc_setbits32(&regs->proctl, PROCTL_BURST_LEN_INCR);
 #endif
 
 	/* Set timout to the maximum value */
@@ -1178,7 +1306,7 @@ static int esdhc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 {
 	struct fsl_esdhc_priv *priv = mmc->priv;
 
-	return esdhc_send_cmd_common(priv, mmc, cmd, data);
+	return esdhc_send_cmd_common(priv, mmc, cmd, data, false);
 }
 
 static int esdhc_set_ios(struct mmc *mmc)
@@ -1311,6 +1439,7 @@ static int fsl_esdhc_init(struct fsl_esdhc_priv *priv,
 	cfg->f_min = 400000;
 	cfg->f_max = min(priv->esdhc.sdhc_clk, (u32)200000000);
 
+	/* Same limit for ADMA2, the block count register is 16 bits wide */
 	cfg->b_max = CONFIG_SYS_MMC_MAX_BLK_COUNT;
 
 	esdhc_write32(&regs->dllctrl, 0);
@@ -1601,6 +1730,16 @@ static int fsl_esdhc_probe(struct udevice *dev)
 	if (data)
 		priv->esdhc.flags = data->flags;
 
+#ifdef ESDHC_USE_ADMA2
+	/* Older uSDHCs may see ADMA length mismatch errors (ERR004536) */
+	if (!(priv->esdhc.flags & ESDHC_FLAG_ERR004536)) {
+		priv->adma_desc_table = memalign(ARCH_DMA_MINALIGN,
+						 ESDHC_ADMA_TABLE_SZ);
+		if (!priv->adma_desc_table)
+			debug("Could not allocate ADMA table, falling back to SDMA\n");
+	}
+#endif
+
 	/*
 	 * TODO:
 	 * Because lack of clk driver, if SDHC clk is not enabled,
@@ -1717,9 +1856,28 @@ static int fsl_esdhc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	struct fsl_esdhc_plat *plat = dev_get_plat(dev);
 	struct fsl_esdhc_priv *priv = dev_get_priv(dev);
 
-	return esdhc_send_cmd_common(priv, &plat->mmc, cmd, data);
+	return esdhc_send_cmd_common(priv, &plat->mmc, cmd, data, false);
+}
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC) && !defined(CONFIG_SYS_FSL_ESDHC_USE_PIO)
+static int fsl_esdhc_start_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+			       struct mmc_data *data)
+{
+	struct fsl_esdhc_plat *plat = dev_get_plat(dev);
+	struct fsl_esdhc_priv *priv = dev_get_priv(dev);
+
+	return esdhc_send_cmd_common(priv, &plat->mmc, cmd, data, true);
 }
 
+static int fsl_esdhc_poll_data(struct udevice *dev, struct mmc_cmd *cmd,
+			       struct mmc_data *data)
+{
+	struct fsl_esdhc_priv *priv = dev_get_priv(dev);
+
+	return esdhc_poll_data_common(priv, cmd, data);
+}
+#endif
+
 static int fsl_esdhc_set_ios(struct udevice *dev)
 {
 	struct fsl_esdhc_plat *plat = dev_get_plat(dev);
@@ -1760,6 +1918,10 @@ static int fsl_esdhc_wait_dat0(struct udevice *dev, int state,
 static const struct dm_mmc_ops fsl_esdhc_ops = {
 	.get_cd		= fsl_esdhc_get_cd,
 	.send_cmd	= fsl_esdhc_send_cmd,
+#if CONFIG_IS_ENABLED(BLK_ASYNC) && !defined(CONFIG_SYS_FSL_ESDHC_USE_PIO)
+	.start_cmd	= fsl_esdhc_start_cmd,
+	.poll_data	= fsl_esdhc_poll_data,
+#endif
 	.set_ios	= fsl_esdhc_set_ios,
 #ifdef MMC_SUPPORTS_TUNING
 	.execute_tuning	= fsl_esdhc_execute_tuning,
@@ -1810,6 +1972,18 @@ static int fsl_esdhc_bind(struct udevice *dev)
 }
 #endif
 
+#ifdef ESDHC_USE_ADMA2
+static int fsl_esdhc_remove(struct udevice *dev)
+{
+	struct fsl_esdhc_priv *priv = dev_get_priv(dev);
+
+	free(priv->adma_desc_table);
+	priv->adma_desc_table = NULL;
+
+	return 0;
+}
+#endif
+
 U_BOOT_DRIVER(fsl_esdhc) = {
 	.name	= "fsl_esdhc",
 	.id	= UCLASS_MMC,
@@ -1820,6 +1994,9 @@ U_BOOT_DRIVER(fsl_esdhc) = {
 	.bind	= fsl_esdhc_bind,
 #endif
 	.probe	= fsl_esdhc_probe,
+#ifdef ESDHC_USE_ADMA2
+	.remove	= fsl_esdhc_remove,
+#endif
 	.plat_auto	= sizeof(struct fsl_esdhc_plat),
 	.priv_auto	= sizeof(struct fsl_esdhc_priv),
 };
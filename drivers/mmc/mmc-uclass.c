@@ -53,6 +53,33 @@ int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 	return dm_mmc_send_cmd(mmc->dev, cmd, data);
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+int dm_mmc_start_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+		     struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+	int ret;
+
+	if (!ops->start_cmd || !ops->poll_data)
+		return -ENOSYS;
+
+	mmmc_trace_before_send(mmc, cmd);
+	ret = ops->start_cmd(dev, cmd, data);
+	mmmc_trace_after_send(mmc, cmd, ret);
+
+	return ret;
+}
+
+int dm_mmc_poll_data(struct udevice *dev, struct mmc_cmd *cmd,
+		     struct mmc_data *data)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	return ops->poll_data(dev, cmd, data);
+}
+#endif
+
 int dm_mmc_set_ios(struct udevice *dev)
 {
 	struct dm_mmc_ops *ops = mmc_get_ops(dev);
@@ -469,14 +496,31 @@ static int mmc_blk_probe(struct udevice *dev)
 
 #if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT) || \
     CONFIG_IS_ENABLED(MMC_HS200_SUPPORT) || \
-    CONFIG_IS_ENABLED(MMC_HS400_SUPPORT)
+    CONFIG_IS_ENABLED(MMC_HS400_SUPPORT) || \
+    CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
 static int mmc_blk_remove(struct udevice *dev)
 {
 	struct udevice *mmc_dev = dev_get_parent(dev);
 	struct mmc_uclass_priv *upriv = dev_get_uclass_priv(mmc_dev);
 	struct mmc *mmc = upriv->mmc;
+	int ret = 0;
+	int err;
+
+	/* Report errors, but always get the card back to a safe mode */
+	/* The OS must find all data on the medium */
+	err = mmc_flush_cache(mmc);
+	if (err && !ret)
+		ret = err;
+
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT) || \
+    CONFIG_IS_ENABLED(MMC_HS200_SUPPORT) || \
+    CONFIG_IS_ENABLED(MMC_HS400_SUPPORT)
+	err = mmc_deinit(mmc);
+	if (err && !ret)
+		ret = err;
+#endif
 
-	return mmc_deinit(mmc);
+	return ret;
 }
 #endif
 
@@ -487,6 +531,10 @@ static const struct blk_ops mmc_blk_ops = {
 	.erase	= mmc_berase,
 #endif
 	.select_hwpart	= mmc_select_hwpart,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.submit	= mmc_bsubmit,
+	.poll	= mmc_bpoll,
+#endif
 };
 
 U_BOOT_DRIVER(mmc_blk) = {
@@ -496,7 +544,8 @@ U_BOOT_DRIVER(mmc_blk) = {
 	.probe		= mmc_blk_probe,
 #if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT) || \
     CONFIG_IS_ENABLED(MMC_HS200_SUPPORT) || \
-    CONFIG_IS_ENABLED(MMC_HS400_SUPPORT)
+    CONFIG_IS_ENABLED(MMC_HS400_SUPPORT) || \
+    CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
 	.remove		= mmc_blk_remove,
 	.flags		= DM_FLAG_OS_PREPARE,
 #endif
@@ -505,6 +505,141 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	return blkcnt;
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC) && CONFIG_IS_ENABLED(DM_MMC)
+/* Start the data transfer for the next chunk of an asynchronous request */
+static int mmc_async_start(struct mmc *mmc, struct blk_req *req)
+{
+	struct mmc_cmd *cmd = &mmc->async_cmd;
+	struct mmc_data *data = &mmc->async_data;
+	lbaint_t start = req->start + req->priv;
+	lbaint_t cur = req->blkcnt - req->priv;
+	uint blksz = mmc->read_bl_len;
+	uint b_max;
+	char *buf;
+
+#if CONFIG_IS_ENABLED(MMC_WRITE)
+	if (req->write)
+		blksz = mmc->write_bl_len;
+#endif
+	buf = (char *)req->buffer + req->priv * blksz;
+	if (req->write)
+		b_max = mmc->cfg->b_max;
+	else
+		b_max = mmc_get_b_max(mmc, buf, cur);
+	if (cur > b_max)
+		cur = b_max;
+
+	if (req->write) {
+		if (cur > 1)
+			cmd->cmdidx = MMC_CMD_WRITE_MULTIPLE_BLOCK;
+		else
+			cmd->cmdidx = MMC_CMD_WRITE_SINGLE_BLOCK;
+		data->src = buf;
+		data->flags = MMC_DATA_WRITE;
+	} else {
+		if (cur > 1)
+			cmd->cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
+		else
+			cmd->cmdidx = MMC_CMD_READ_SINGLE_BLOCK;
+		data->dest = buf;
+		data->flags = MMC_DATA_READ;
+	}
+
+	if (mmc->high_capacity)
+		cmd->cmdarg = start;
+	else
+		cmd->cmdarg = start * blksz;
+	cmd->resp_type = MMC_RSP_R1;
+
+	data->blocks = cur;
+	data->blocksize = blksz;
+	mmc->async_cur = cur;
+
+	return dm_mmc_start_cmd(mmc->dev, cmd, data);
+}
+
+int mmc_bsubmit(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	int err;
+
+	if (!mmc)
+		return -ENODEV;
+
+	/* Only one data transfer can be active at a time */
+	if (mmc->async_req)
+		return -EBUSY;
+
+	if (!req->blkcnt)
+		return -ENOSYS;
+
+	if ((req->start + req->blkcnt) > block_dev->lba)
+		return -EINVAL;
+
+	err = blk_dselect_hwpart(block_dev, block_dev->hwpart);
+	if (err < 0)
+		return err;
+
+#if CONFIG_IS_ENABLED(MMC_WRITE)
+	if (req->write)
+		err = mmc_set_blocklen(mmc, mmc->write_bl_len);
+	else
+#endif
+		err = mmc_set_blocklen(mmc, mmc->read_bl_len);
+	if (err)
+		return err;
+
+	req->priv = 0;
+	err = mmc_async_start(mmc, req);
+	if (!err)
+		mmc->async_req = req;
+
+	return err;
+}
+
+long mmc_bpoll(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	struct mmc_cmd cmd;
+	int err;
+
+	if (!mmc || (mmc->async_req != req))
+		return -EINVAL;
+
+	err = dm_mmc_poll_data(mmc->dev, &mmc->async_cmd, &mmc->async_data);
+	if (err == -EINPROGRESS)
+		return err;
+
+	if (!err && (mmc->async_cur > 1)) {
+		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+		cmd.cmdarg = 0;
+		cmd.resp_type = MMC_RSP_R1b;
+		err = mmc_send_cmd(mmc, &cmd, NULL);
+	}
+
+	/* Waiting for the ready status */
+	if (!err && req->write)
+		err = mmc_poll_for_busy(mmc, 1000);
+
+	if (!err) {
+		req->priv += mmc->async_cur;
+		if (req->priv < req->blkcnt) {
+			err = mmc_async_start(mmc, req);
+			if (!err)
+				return -EINPROGRESS;
+		}
+	}
+
+	mmc->async_req = NULL;
+	if (err)
+		return err;
+
+	return req->blkcnt;
+}
+#endif
+
 static int mmc_go_idle(struct mmc *mmc)
 {
 	struct mmc_cmd cmd;
@@ -2274,6 +2409,22 @@ static int mmc_startup_v4(struct mmc *mmc)
 	if (mmc->version >= MMC_VERSION_4_5)
 		mmc->gen_cmd6_time = ext_csd[EXT_CSD_GENERIC_CMD6_TIME];
 
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+	mmc->cache_size = 0;
+	mmc->cache_on = 0;
+	if (mmc->version >= MMC_VERSION_4_5) {
+		mmc->cache_size = ext_csd[EXT_CSD_CACHE_SIZE] << 0
+				| ext_csd[EXT_CSD_CACHE_SIZE + 1] << 8
+				| ext_csd[EXT_CSD_CACHE_SIZE + 2] << 16
+				| ext_csd[EXT_CSD_CACHE_SIZE + 3] << 24;
+		mmc->cache_on = ext_csd[EXT_CSD_CACHE_CTRL] & 0x1;
+	}
+	/* Not fatal, the device simply keeps writing through */
+	if (mmc->cache_size && !mmc->cache_on &&
+	    !mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CACHE_CTRL, 1))
+		mmc->cache_on = 1;
+#endif
+
 	/* The partition data may be non-zero but it is only
 	 * effective if PARTITION_SETTING_COMPLETED is set in
 	 * EXT_CSD, so ignore any data if this bit is not set,
@@ -222,3 +222,83 @@ ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 
 	return blkcnt;
 }
+
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+/* Writing back a full cache may take a while */
+#define MMC_CACHE_FLUSH_TIMEOUT_MS	30000
+
+int mmc_flush_cache(struct mmc *mmc)
+{
+	struct mmc_cmd cmd;
+	int err;
+
+	if (!mmc->cache_on)
+		return 0;
+
+	/*
+	 * Do not use mmc_switch() here, its timeout is only meant for
+	 * register changes and is far too short for a cache flush.
+	 */
+	cmd.cmdidx = MMC_CMD_SWITCH;
+	cmd.resp_type = MMC_RSP_R1b;
+	cmd.cmdarg = (MMC_SWITCH_MODE_WRITE_BYTE << 24) |
+		     (EXT_CSD_FLUSH_CACHE << 16) | (1 << 8);
+
+	err = mmc_send_cmd(mmc, &cmd, NULL);
+	if (!err)
+		err = mmc_poll_for_busy(mmc, MMC_CACHE_FLUSH_TIMEOUT_MS);
+	if (err)
+		printf("mmc cache flush failed (%d)\n", err);
+
+	return err;
+}
+
+void mmc_flush_caches(void)
+{
+#if CONFIG_IS_ENABLED(DM_MMC)
+	struct udevice *dev;
+	struct uclass *uc;
+
+	if (uclass_get(UCLASS_MMC, &uc))
+		return;
+
+	uclass_foreach_dev(dev, uc) {
+		if (device_active(dev))
+			mmc_flush_cache(mmc_get_mmc_dev(dev));
+	}
+#else
+	struct mmc *mmc;
+	int i;
+
+	for (i = 0; i < get_mmc_num(); i++) {
+		mmc = find_mmc_device(i);
+		if (mmc)
+			mmc_flush_cache(mmc);
+	}
+#endif
+}
+
+int mmc_cache_ctrl(struct mmc *mmc, bool enable)
+{
+	int err;
+
+	if (IS_SD(mmc) || !mmc->cache_size)
+		return -EMEDIUMTYPE;
+
+	if (mmc->cache_on == enable)
+		return 0;
+
+	if (!enable) {
+		err = mmc_flush_cache(mmc);
+		if (err)
+			return err;
+	}
+
+	err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CACHE_CTRL,
+			 enable ? 1 : 0);
+	if (!err)
+		mmc->cache_on = enable;
+
+	return err;
+}
+#endif /* CONFIG_MMC_WRITE_CACHE */
@@ -26,6 +26,7 @@ struct sandbox_mmc_plat {
 
 struct sandbox_mmc_priv {
 	u8 buf[MMC_CAPACITY];
+	int polls;		/* Polls until a started transfer is done */
 };
 
 /**
@@ -120,6 +121,33 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/*
+ * Emulate a transfer that takes some time: the data is only moved when the
+ * transfer is polled for the second time.
+ */
+static int sandbox_mmc_start_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+				 struct mmc_data *data)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	priv->polls = 2;
+
+	return 0;
+}
+
+static int sandbox_mmc_poll_data(struct udevice *dev, struct mmc_cmd *cmd,
+				 struct mmc_data *data)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	if (--priv->polls > 0)
+		return -EINPROGRESS;
+
+	return sandbox_mmc_send_cmd(dev, cmd, data);
+}
+#endif
+
 static int sandbox_mmc_set_ios(struct udevice *dev)
 {
 	return 0;
@@ -132,6 +160,10 @@ static int sandbox_mmc_get_cd(struct udevice *dev)
 
 static const struct dm_mmc_ops sandbox_mmc_ops = {
 	.send_cmd = sandbox_mmc_send_cmd,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.start_cmd = sandbox_mmc_start_cmd,
+	.poll_data = sandbox_mmc_poll_data,
+#endif
 	.set_ios = sandbox_mmc_set_ios,
 	.get_cd = sandbox_mmc_get_cd,
 };
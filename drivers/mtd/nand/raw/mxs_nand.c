@@ -642,6 +642,17 @@ static bool mxs_nand_erased_page(struct mtd_info *mtd, struct nand_chip *nand,
 			return false;
 	}
 
+	/*
+	 * If a cached sequential read is running, the chip is busy loading
+	 * the next page. Finish this before reading the page again in raw
+	 * mode. The sequence is ended here, so nand_do_read_ops() starts a
+	 * new one for the next page with nand_read_page_op() and
+	 * READCACHESEQ.
+	 */
+	if (nand->cache_read_next) {
+		nand->cmdfunc(mtd, NAND_CMD_READCACHEEND, -1, -1);
+		nand->cache_read_next = 0;
+	}
 	nand->cmdfunc(mtd, NAND_CMD_READ0, 0, page);
 	nand->read_buf(mtd, buf, mtd->writesize);
 
@@ -1403,7 +1414,7 @@ int mxs_nand_init_ctrl(struct mxs_nand_info *nand_info)
 #endif
 
 	nand_set_controller_data(nand, nand_info);
-	nand->options |= NAND_NO_SUBPAGE_WRITE;
+	nand->options |= NAND_NO_SUBPAGE_WRITE | NAND_CACHE_READ;
 
 	if (nand_info->dev)
 		nand->flash_node = dev_of_offset(nand_info->dev);
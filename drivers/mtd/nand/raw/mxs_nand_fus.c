@@ -94,6 +94,8 @@ struct mxs_nand_priv {
 	uint32_t cmd_queue_len;		/* Current command queue length */
 	uint8_t column_cycles;		/* Number of column cycles */
 	uint8_t row_cycles;		/* Number of row cycles */
+	uint8_t read_pending;		/* READ0 queued, READSTART not yet */
+	uint8_t cache_read;		/* Page is ready in cache register */
 };
 
 /*
@@ -1132,6 +1134,8 @@ static void mxs_nand_command(struct mtd_info *mtd, uint command, int column,
 	 * The command sequence should be:
 	 *   NAND_CMD_READ0 Col+Row -> NAND_CMD_READSTART -> Ready -> Read data
 	 *	  {-> NAND_CMD_RNDOUT col -> NAND_CMD_RNDOUTSTART -> Read data}
+	 *   NAND_CMD_READ0 Col+Row {-> NAND_CMD_READCACHESEQ -> Read data}
+	 *	  -> NAND_CMD_READCACHEEND -> Read data
 	 *   NAND_CMD_SEQIN Col+Row -> Write data
 	 *	  {-> NAND_CMD_RNDIN Col -> Write Data}
 	 *	  -> NAND_CMD_PAGEPROG -> Ready
@@ -1154,12 +1158,34 @@ static void mxs_nand_command(struct mtd_info *mtd, uint command, int column,
 	case NAND_CMD_ERASE2:
 		/* Add DMA descriptor with command + column and/or row */
 		mxs_nand_add_cmd_desc(priv, command, column, page, -1);
+		priv->read_pending = (command == NAND_CMD_READ0);
+		priv->cache_read = 0;
 		/* In case of NAND_CMD_PAGEPROG and NAND_CMD_ERASE2,
 		   chip->waitfunc() is called later, so we need not wait now.
 		   FIXME: In case of NAND_CMD_RNDIN we should have a delay of
 		   t_CCS here so that the chip can switch columns */
 		break;
 
+	case NAND_CMD_READCACHESEQ:
+	case NAND_CMD_READCACHEEND:
+		/*
+		 * Cached sequential read: if this is the first page, load it
+		 * from the array now. Then move it to the cache register and
+		 * let the chip load the next page meanwhile (31h), or end the
+		 * sequence (3Fh). The following read_page() only transfers
+		 * the data from the cache register.
+		 */
+		if (priv->read_pending) {
+			mxs_nand_add_cmd_desc(priv, NAND_CMD_READSTART,
+					      -1, -1, -1);
+			priv->read_pending = 0;
+			mxs_nand_wait_ready(mtd, MXS_NAND_TIMEOUT_DATA);
+		}
+		mxs_nand_add_cmd_desc(priv, command, -1, -1, -1);
+		mxs_nand_wait_ready(mtd, MXS_NAND_TIMEOUT_DATA);
+		priv->cache_read = 1;
+		break;
+
 	case NAND_CMD_PARAM:
 	case NAND_CMD_GET_FEATURES:
 		/* Add DMA descriptor with command and one address byte */
@@ -1305,12 +1331,17 @@ static int mxs_nand_read_page(struct mtd_info *mtd, struct nand_chip *chip,
 	 * column/row bytes was already created in nand_do_read_ops(). Now add
 	 * a DMA descriptor for the second command byte NAND_CMD_READSTART and
 	 * a DMA descriptor to wait for ready. Execute this DMA chain and
-	 * check for timeout.
+	 * check for timeout. In a cached sequential read, the page is already
+	 * waiting in the cache register.
 	 */
-	chip->cmdfunc(mtd, NAND_CMD_READSTART, -1, -1);
-	ret = mxs_nand_wait_ready(mtd, MXS_NAND_TIMEOUT_DATA);
-	if (ret)
-		return ret;
+	if (priv->cache_read) {
+		priv->cache_read = 0;
+	} else {
+		chip->cmdfunc(mtd, NAND_CMD_READSTART, -1, -1);
+		ret = mxs_nand_wait_ready(mtd, MXS_NAND_TIMEOUT_DATA);
+		if (ret)
+			return ret;
+	}
 
 	/* Add DMA descriptor to enable the BCH block and read */
 	d = mxs_nand_get_dma_desc(priv);
@@ -1472,6 +1503,11 @@ static int mxs_nand_read_page(struct mtd_info *mtd, struct nand_chip *chip,
 			refresh = 0;
 		mtd->extradata = refresh << chip->phys_erase_shift;
 	}
+
+	/* Collect bitflip statistics */
+	nand_refresh_account(mtd,
+			     page >> (chip->phys_erase_shift - chip->page_shift),
+			     ret);
 #endif
 
 	/* Return maximum number of bitflips across all chunks */
@@ -1760,7 +1796,8 @@ void mxs_nand_register(int nfc_hw_id,
 	chip->write_buf = mxs_nand_write_buf;
 	chip->waitfunc = mxs_nand_waitfunc;
 	chip->options = pdata ? pdata->options : 0;
-	chip->options |= NAND_BBT_SCAN2NDPAGE | NAND_NO_SUBPAGE_WRITE;
+	chip->options |= NAND_BBT_SCAN2NDPAGE | NAND_NO_SUBPAGE_WRITE
+		| NAND_CACHE_READ;
 	chip->badblockpos = 0;
 
 	/* If this is the first call, init the GPMI/BCH/DMA system */
@@ -2323,6 +2323,36 @@ static int nand_setup_read_retry(struct mtd_info *mtd, int retry_mode)
 	return chip->setup_read_retry(mtd, retry_mode);
 }
 
+/**
+ * nand_cache_read_end - [INTERN] Get last page of a cached sequential read
+ * @mtd: MTD device structure
+ * @ops: oob ops structure
+ * @realpage: page where reading starts
+ * @col: column where reading starts
+ * @readlen: number of bytes to read
+ * @skippage: first page that is not in the skip region
+ *
+ * Pages can be read with READ CACHE SEQUENTIAL if they are read completely
+ * with ECC and without OOB. The run must not cross the end of the block.
+ * Returns @realpage if no cached read is possible.
+ */
+static int nand_cache_read_end(struct mtd_info *mtd, struct mtd_oob_ops *ops,
+			       int realpage, uint32_t col, uint32_t readlen,
+			       int skippage)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	int lastpage;
+
+	if (!(chip->options & NAND_CACHE_READ) || col || ops->oobbuf
+	    || (ops->mode == MTD_OPS_RAW) || (realpage < skippage))
+		return realpage;
+
+	lastpage = realpage | ((1 << (chip->phys_erase_shift
+				      - chip->page_shift)) - 1);
+
+	return min(lastpage, realpage + (int)(readlen >> chip->page_shift) - 1);
+}
+
 /**
  * nand_do_read_ops - [INTERN] Read data with ECC
  * @mtd: MTD device structure
@@ -2348,6 +2378,7 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 	uint8_t *bufpoi;
 	int retry_mode = 0;
 	int skippage = (int)(mtd->skip >> chip->page_shift);
+	int cache_end = 0;
 
 	ops->retlen = 0;
 	if (oobbuf)
@@ -2381,15 +2412,44 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 		aligned = (bytes == mtd->writesize);
 
 		/* Is the current page in the buffer? */
-		if (realpage != chip->pagebuf || oobbuf) {
+		if (realpage != chip->pagebuf || oobbuf
+		    || chip->cache_read_next) {
 			unsigned int prev_corrected = mtd->ecc_stats.corrected;
 
 			bufpoi = aligned ? buf : chip->buffers->databuf;
 
-			if (nand_standard_page_accessors(&chip->ecc)) {
+			if (chip->cache_read_next) {
+				/* Get the loaded page, load the next one */
+				if (realpage < cache_end) {
+					chip->cmdfunc(mtd,
+						      NAND_CMD_READCACHESEQ,
+						      -1, -1);
+					chip->cache_read_next = page + 1;
+				} else {
+					chip->cmdfunc(mtd,
+						      NAND_CMD_READCACHEEND,
+						      -1, -1);
+					chip->cache_read_next = 0;
+				}
+			} else if (nand_standard_page_accessors(&chip->ecc)) {
 				ret = nand_read_page_op(chip, page, 0, NULL, 0);
 				if (ret)
 					break;
+
+				/*
+				 * If more pages of this block are read, let
+				 * the chip load the next page while this one
+				 * is transferred.
+				 */
+				cache_end = nand_cache_read_end(mtd, ops,
+						realpage, col, readlen,
+						skippage);
+				if (cache_end > realpage) {
+					chip->cmdfunc(mtd,
+						      NAND_CMD_READCACHESEQ,
+						      -1, -1);
+					chip->cache_read_next = page + 1;
+				}
 			}
 
 			/* Now read the page into the buffer: if we are at
@@ -2475,6 +2535,12 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 			chip->select_chip(mtd, chipnr);
 		}
 	}
+
+	/* Stop a cached sequential read that was aborted by an error */
+	if (chip->cache_read_next) {
+		chip->cmdfunc(mtd, NAND_CMD_READCACHEEND, -1, -1);
+		chip->cache_read_next = 0;
+	}
 	chip->select_chip(mtd, -1);
 
 	ops->retlen = ops->len - (size_t) readlen;
@@ -5355,6 +5421,12 @@ int nand_scan_tail(struct mtd_info *mtd)
 	/* Invalidate the pagebuffer reference */
 	chip->pagebuf = -1;
 
+	/* READ CACHE SEQUENTIAL is optional, the chip must support it, too */
+	if (!chip->onfi_version || (mtd->writesize <= 512)
+	    || !(le16_to_cpu(chip->onfi_params.opt_cmd)
+		 & ONFI_OPT_CMD_READ_CACHE))
+		chip->options &= ~NAND_CACHE_READ;
+
 	/* Large page NAND with SOFT_ECC should support subpage reads */
 	switch (ecc->mode) {
 	case NAND_ECC_SOFT:
@@ -116,6 +116,38 @@
  *       block could be restored (somewhere between steps 2 and 4). Some data
  *       was actually lost. This is very very unlikely to happen.
  *
+ * Deferred refresh:
+ *
+ * A refresh takes some time, as a whole block has to be copied twice. If it
+ * is triggered while loading a kernel or a root filesystem, this delays the
+ * boot process noticeably. So blocks with too many bitflips are not refreshed
+ * immediately when they are detected in nand_read_skip_bad(). Instead they
+ * are put into a refresh queue that is processed as a batch at the next
+ * start in board_late_init() or by command "nand refresh".
+ *
+ * To survive a reset, the queue is also stored in the backup block. As the
+ * backup block is erased when not in use, we write the whole queue to the
+ * next free page of this block whenever a new entry is added. The last page
+ * of the backup block is never used for this as it holds the refresh offset
+ * during a refresh. Each copy gets a sequence number and at startup, the
+ * copy with the highest number is the current queue.
+ *
+ * The backup block is erased in step 1 of each refresh, which would also
+ * discard the queue. So when processing the batch, the remaining queue is
+ * first written to a spare block, i.e. the next good block of the backup
+ * region, and only then the refresh is started. When the refresh is done,
+ * the remaining queue is saved to the backup block again. If the refresh is
+ * interrupted, the refresh itself is resumed as described above and the
+ * remaining queue is found in the spare block. If the backup region only
+ * consists of one block, there is no spare block and the remaining queue is
+ * lost in this case. The blocks will then be queued again when they are read
+ * the next time.
+ *
+ * In addition, the driver reports the number of corrected bitflips of each
+ * page read. These are collected in a histogram and the maximum bitflip count
+ * of each block is kept in RAM. This can be shown with "nand refresh stats"
+ * and gives an impression of the state of the NAND flash.
+ *
  * Remark:
  * The following code uses 0 for invalid offsets. This silently assumes that
  * block 0 (at offset 0) is always required for booting and can neither be
@@ -123,9 +155,11 @@
  */
 
 #include <common.h>
+#include <malloc.h>
 #include <linux/errno.h>
 #include <linux/mtd/mtd.h>
 #include <nand.h>
+#include <u-boot/crc.h>
 
 typedef struct erase_info erase_info_t;
 typedef struct mtd_info	  mtd_info_t;
@@ -134,6 +168,30 @@ typedef struct mtd_info	  mtd_info_t;
 static u_char pagebuf[NAND_MAX_PAGESIZE];
 static u_char oobbuf[NAND_MAX_OOBSIZE];
 
+#define NAND_REFRESH_HIST_SIZE 16	/* Last entry counts all higher values */
+#define NAND_REFRESH_QUEUE_SIZE 32	/* Max. number of queued blocks */
+#define NAND_REFRESH_QUEUE_MAGIC 0x5152524E /* "NRRQ" */
+
+/* Bitflip statistics and refresh queue, one per NAND device */
+struct nand_refresh_stats {
+	unsigned int hist[NAND_REFRESH_HIST_SIZE]; /* Page reads by bitflips */
+	u8 *blockflips;			/* Max. bitflips per block */
+	u32 blocks;			/* Number of entries in blockflips[] */
+	unsigned int queued;		/* Number of blocks in queue[] */
+	u32 queue[NAND_REFRESH_QUEUE_SIZE]; /* Block numbers to refresh */
+	u32 queue_page;			/* Next free page in backup block */
+	u32 seq;			/* Sequence number of last copy */
+};
+
+/* Layout of the queue copy stored in a page of the backup block */
+struct nand_refresh_queue_page {
+	u32 magic;			/* NAND_REFRESH_QUEUE_MAGIC */
+	u32 queued;			/* Number of entries in queue[] */
+	u32 queue[NAND_REFRESH_QUEUE_SIZE]; /* Block numbers to refresh */
+	u32 seq;			/* Newest copy has highest number */
+	u32 crc32;			/* CRC32 of all previous entries */
+};
+
 
 /* Erase block at given offset; mark as bad if it fails */
 static int erase_block(struct mtd_info *mtd, loff_t offset)
@@ -393,7 +451,8 @@ void nand_refresh_free_backup(struct mtd_info *mtd)
 	nr_debug("Refresh offset in backup block invalidated\n");
 
 	/* Step 6: Erase backup block */
-	erase_block(mtd, mtd->backupoffs);
+	if (!erase_block(mtd, mtd->backupoffs) && mtd->refresh_stats)
+		mtd->refresh_stats->queue_page = 0;
 
 	nr_debug("Backup block erased\n");
 }
@@ -503,28 +562,15 @@ loff_t nand_refresh_final_offset(struct mtd_info *mtd, loff_t offset)
 
 
 /*
- * At system start, check for any interrupted block refresh and resume it if
- * possible.
- *
- * Return value: 0:    Resume successful or no resume necessary
- *               -EIO: Resume failed, we are in emergency mode now
+ * Check for any interrupted block refresh and resume it if possible. If the
+ * resume fails, we are in emergency mode afterwards.
  */
-void nand_refresh_init(struct mtd_info *mtd)
+static void resume_refresh(struct mtd_info *mtd)
 {
 	int rval;
 	loff_t refreshoffs;
 	mtd_oob_ops_t ops;
 
-	/* Return if NAND device doesn't exist. */
-	if (mtd == NULL)
-		return;
-
-	/* Get the first possible backup block. If there is no backup block
-	   available at all, it is not possible that a block refresh was in
-	   progress the last time. Go to normal mode then. */
-	if (!get_backupblock(mtd))
-		return;
-
 	/* Read the last page of the backup block. If we can't read this page,
 	   we may have been interrupted at the end of step 2 or in steps 5 or
 	   6. In both cases we can ignore the backup block as our original
@@ -573,3 +619,353 @@ void nand_refresh_init(struct mtd_info *mtd)
 	if (!finish_refresh(mtd, refreshoffs))
 		printf("%s: Interrupted refresh completed\n", mtd->name);
 }
+
+/* Return number of pages in the backup block that may hold a queue copy */
+static u32 queue_pages(struct mtd_info *mtd)
+{
+	return (mtd->erasesize / mtd->writesize) - 1;
+}
+
+/*
+ * Return the block following the backup block in the backup region, which
+ * holds the remaining queue while the batch is processed, or 0 if there is
+ * none.
+ */
+static loff_t get_queue_spare(struct mtd_info *mtd)
+{
+	loff_t spare = mtd->backupoffs;
+	loff_t backupend = mtd->backupend & ~(mtd->erasesize - 1);
+
+	do {
+		if (spare > backupend)
+			spare -= mtd->erasesize;
+		else if (spare < backupend)
+			spare += mtd->erasesize;
+		else
+			return 0;
+	} while (mtd_block_isbad(mtd, spare));
+
+	return spare;
+}
+
+/* Write a copy of the current refresh queue to the given page */
+static int write_queue(struct mtd_info *mtd, loff_t offs)
+{
+	struct nand_refresh_stats *stats = mtd->refresh_stats;
+	struct nand_refresh_queue_page *qp;
+	size_t len = mtd->writesize;
+	int rval;
+
+	memset(pagebuf, 0xFF, mtd->writesize);
+	qp = (struct nand_refresh_queue_page *)pagebuf;
+	qp->magic = NAND_REFRESH_QUEUE_MAGIC;
+	qp->queued = stats->queued;
+	memcpy(qp->queue, stats->queue, sizeof(qp->queue));
+	qp->seq = ++stats->seq;
+	qp->crc32 = crc32(0, pagebuf, offsetof(typeof(*qp), crc32));
+
+	rval = mtd_write(mtd, offs, len, &len, pagebuf);
+	if (rval)
+		printf("%s: Saving refresh queue at 0x%08llx failed with %d\n",
+		       mtd->name, offs, rval);
+	else
+		nr_debug("Refresh queue saved at 0x%08llx\n", offs);
+
+	return rval;
+}
+
+/* Store a copy of the current refresh queue in the backup block */
+static void save_queue(struct mtd_info *mtd)
+{
+	struct nand_refresh_stats *stats = mtd->refresh_stats;
+	loff_t offs;
+
+	/* No persistent queue in EMERGENCY MODE, backup block is in use */
+	if (!mtd->backupoffs || mtd->replaceoffs)
+		return;
+
+	/* If all pages are used, start over with an empty backup block */
+	if (stats->queue_page >= queue_pages(mtd)) {
+		if (erase_block(mtd, mtd->backupoffs))
+			return;
+		stats->queue_page = 0;
+	}
+
+	/* Even if this fails, the page is not usable anymore */
+	offs = mtd->backupoffs + stats->queue_page * mtd->writesize;
+	stats->queue_page++;
+	write_queue(mtd, offs);
+}
+
+/*
+ * Read the queue copy at the given offset to pagebuf. Return 0 if it is
+ * valid, -ENOENT if the page holds anything else and the read error else.
+ */
+static int read_queue(struct mtd_info *mtd, loff_t offs)
+{
+	struct nand_refresh_queue_page *qp;
+	size_t len = mtd->writesize;
+	int rval;
+
+	rval = mtd_read(mtd, offs, len, &len, pagebuf);
+	if (rval && (rval != -EUCLEAN))
+		return rval;
+
+	qp = (struct nand_refresh_queue_page *)pagebuf;
+	if ((qp->magic != NAND_REFRESH_QUEUE_MAGIC)
+	    || (qp->queued > NAND_REFRESH_QUEUE_SIZE)
+	    || (qp->crc32 != crc32(0, pagebuf, offsetof(typeof(*qp), crc32))))
+		return -ENOENT;
+
+	return 0;
+}
+
+/* Take the queue copy in pagebuf if it is newer than the current queue */
+static void take_queue(struct mtd_info *mtd, bool *found)
+{
+	struct nand_refresh_stats *stats = mtd->refresh_stats;
+	struct nand_refresh_queue_page *qp;
+
+	qp = (struct nand_refresh_queue_page *)pagebuf;
+	if (*found && ((s32)(qp->seq - stats->seq) <= 0))
+		return;
+
+	stats->queued = qp->queued;
+	memcpy(stats->queue, qp->queue, sizeof(stats->queue));
+	stats->seq = qp->seq;
+	*found = true;
+}
+
+/*
+ * Load the last valid copy of the refresh queue from the backup block and
+ * determine the next free page.
+ */
+static void load_queue(struct mtd_info *mtd)
+{
+	struct nand_refresh_stats *stats = mtd->refresh_stats;
+	bool found = false;
+	loff_t spare;
+	u32 page;
+	int rval = 0;
+	int i;
+
+	for (page = 0; page < queue_pages(mtd); page++) {
+		rval = read_queue(mtd, mtd->backupoffs + page * mtd->writesize);
+		if (rval)
+			break;
+		take_queue(mtd, &found);
+	}
+
+	/* An empty page is the next free page. On any other content, the
+	   backup block has to be erased before the queue can be saved. */
+	stats->queue_page = page;
+	if (page < queue_pages(mtd)) {
+		if (rval != -ENOENT)
+			stats->queue_page = queue_pages(mtd);
+		else {
+			for (i = 0; i < mtd->writesize; i++) {
+				if (pagebuf[i] != 0xFF) {
+					stats->queue_page = queue_pages(mtd);
+					break;
+				}
+			}
+		}
+	}
+
+	/* If processing the batch was interrupted, the spare block holds a
+	   newer copy than the backup block */
+	spare = get_queue_spare(mtd);
+	if (spare && !read_queue(mtd, spare))
+		take_queue(mtd, &found);
+
+	if (stats->queued)
+		printf("%s: %u block(s) pending for refresh\n", mtd->name,
+		       stats->queued);
+}
+
+/*
+ * Refresh the given block while other blocks are queued. The backup block is
+ * erased by the refresh, so keep the queue in the spare block in the meantime
+ * and save it to the backup block again afterwards.
+ */
+static int refresh_keep_queue(struct mtd_info *mtd, u32 block)
+{
+	struct nand_refresh_stats *stats = mtd->refresh_stats;
+	loff_t spare;
+	int rval;
+
+	spare = get_queue_spare(mtd);
+	if (spare && !erase_block(mtd, spare))
+		write_queue(mtd, spare);
+
+	/* Even a failed refresh may leave data in the backup block,
+	   so erase it before saving the queue there again */
+	stats->queue_page = queue_pages(mtd);
+	rval = nand_refresh(mtd, (loff_t)block * mtd->erasesize);
+	if (!rval && (block < stats->blocks))
+		stats->blockflips[block] = 0;
+	save_queue(mtd);
+
+	return rval;
+}
+
+/*
+ * Queue the block with the given offset for refresh. The refresh will be done
+ * at the next start or with "nand refresh". If the block can not be queued,
+ * it is refreshed immediately. The return value is the same as for
+ * nand_refresh().
+ */
+int nand_refresh_queue(struct mtd_info *mtd, loff_t refreshoffs)
+{
+	struct nand_refresh_stats *stats = mtd->refresh_stats;
+	u32 block = mtd_div_by_eb(refreshoffs, mtd);
+	unsigned int i;
+
+	/* Without statistics, the queue of the last session was not loaded.
+	   Do not erase it with an immediate refresh. */
+	if (!stats && mtd->backupoffs && !mtd->replaceoffs
+	    && !read_queue(mtd, mtd->backupoffs)) {
+		printf("%s: Refresh at 0x%08llx postponed, queue pending\n",
+		       mtd->name, (loff_t)block * mtd->erasesize);
+		return -EUCLEAN;
+	}
+
+	if (!stats || !mtd->backupoffs || mtd->replaceoffs)
+		return nand_refresh(mtd, refreshoffs);
+
+	for (i = 0; i < stats->queued; i++) {
+		if (stats->queue[i] == block)
+			return -EUCLEAN;
+	}
+
+	if (stats->queued >= NAND_REFRESH_QUEUE_SIZE)
+		return refresh_keep_queue(mtd, block);
+
+	stats->queue[stats->queued++] = block;
+	printf("%s: Block with many bitflips at 0x%08llx queued for refresh\n",
+	       mtd->name, (loff_t)block * mtd->erasesize);
+	save_queue(mtd);
+
+	return -EUCLEAN;
+}
+
+/* Refresh all queued blocks */
+void nand_refresh_run_queue(struct mtd_info *mtd)
+{
+	struct nand_refresh_stats *stats;
+	u32 block;
+
+	if (!mtd || !mtd->refresh_stats)
+		return;
+
+	stats = mtd->refresh_stats;
+
+	while (stats->queued && !mtd->replaceoffs) {
+		block = stats->queue[0];
+		stats->queued--;
+		memmove(stats->queue, stats->queue + 1,
+			stats->queued * sizeof(stats->queue[0]));
+		refresh_keep_queue(mtd, block);
+	}
+
+	/* Only in EMERGENCY MODE something may be left in the queue; it will
+	   stay in RAM because the backup block is in use */
+}
+
+/* Called by the NAND driver for each ECC page read with corrected bitflips */
+void nand_refresh_account(struct mtd_info *mtd, u32 block,
+			  unsigned int bitflips)
+{
+	struct nand_refresh_stats *stats = mtd->refresh_stats;
+
+	if (!stats)
+		return;
+
+	if (bitflips >= NAND_REFRESH_HIST_SIZE)
+		stats->hist[NAND_REFRESH_HIST_SIZE - 1]++;
+	else
+		stats->hist[bitflips]++;
+
+	if (bitflips > 255)
+		bitflips = 255;
+	if ((block < stats->blocks) && (bitflips > stats->blockflips[block]))
+		stats->blockflips[block] = bitflips;
+}
+
+/* Show bitflip histogram, blocks with bitflips and refresh queue */
+void nand_refresh_show_stats(struct mtd_info *mtd)
+{
+	struct nand_refresh_stats *stats = mtd->refresh_stats;
+	unsigned int i;
+	u32 block;
+
+	if (!stats) {
+		printf("%s: No refresh statistics available\n", mtd->name);
+		return;
+	}
+
+	printf("Page reads by number of bitflips (refresh at %u):\n",
+	       mtd->bitflip_threshold);
+	for (i = 0; i < NAND_REFRESH_HIST_SIZE; i++) {
+		if (!stats->hist[i])
+			continue;
+		printf("  %2u%s: %u\n", i,
+		       (i == NAND_REFRESH_HIST_SIZE - 1) ? "+" : " ",
+		       stats->hist[i]);
+	}
+
+	puts("Blocks with bitflips (max. per page):\n");
+	for (block = 0; block < stats->blocks; block++) {
+		if (stats->blockflips[block])
+			printf("  0x%08llx: %u\n",
+			       (loff_t)block * mtd->erasesize,
+			       stats->blockflips[block]);
+	}
+
+	printf("Refresh queue: %u block(s)\n", stats->queued);
+	for (i = 0; i < stats->queued; i++)
+		printf("  0x%08llx\n", (loff_t)stats->queue[i] * mtd->erasesize);
+	if (mtd->replaceoffs)
+		printf("EMERGENCY MODE: block at 0x%08llx replaced by 0x%08llx\n",
+		       mtd->replaceoffs, mtd->backupoffs);
+}
+
+/*
+ * At system start, set up bitflip statistics, check for any interrupted
+ * block refresh and resume it if possible. Then load the refreshs that were
+ * queued in the previous session; they are done later in board_late_init()
+ * by calling nand_refresh_run_queue().
+ */
+void nand_refresh_init(struct mtd_info *mtd)
+{
+	struct nand_refresh_stats *stats;
+
+	/* Return if NAND device doesn't exist. */
+	if (mtd == NULL)
+		return;
+
+	stats = calloc(1, sizeof(*stats));
+	if (stats) {
+		stats->blocks = mtd_div_by_eb(mtd->size, mtd);
+		stats->blockflips = calloc(stats->blocks, 1);
+		if (!stats->blockflips) {
+			free(stats);
+			stats = NULL;
+		}
+	}
+	if (!stats)
+		printf("%s: No memory for refresh statistics\n", mtd->name);
+	mtd->refresh_stats = stats;
+
+	/* Get the first possible backup block. If there is no backup block
+	   available at all, it is not possible that a block refresh was in
+	   progress the last time. Go to normal mode then. */
+	if (!get_backupblock(mtd))
+		return;
+
+	resume_refresh(mtd);
+
+	/* In EMERGENCY MODE, the backup block does not hold a queue */
+	if (stats && !mtd->replaceoffs)
+		load_queue(mtd);
+}
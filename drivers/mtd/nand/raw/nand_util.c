@@ -801,7 +801,7 @@ int nand_read_skip_bad(struct mtd_info *mtd, loff_t offset, size_t *length,
 		rval = nand_read(mtd, offset, &read_length, buffer);
 #ifdef CONFIG_NAND_REFRESH
 	        if (rval == -EUCLEAN)
-			rval = nand_refresh(mtd, offset);
+			rval = nand_refresh_queue(mtd, offset);
 #endif
 		if (rval && rval != -EUCLEAN) {
 			printf("NAND read failed at 0x%08llx with error %d\n",
@@ -13,6 +13,7 @@
 #include <errno.h>
 #include <hang.h>
 #include <log.h>
+#include <mmc.h>
 #include <regmap.h>
 #include <spl.h>
 #include <sysreset.h>
@@ -123,6 +124,7 @@ void reset_cpu(ulong addr)
 int do_reset(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 {
 	printf("resetting ...\n");
+	mmc_flush_caches();
 	mdelay(100);
 
 	sysreset_walk_halt(SYSRESET_COLD);
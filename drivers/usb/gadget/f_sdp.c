@@ -26,6 +26,7 @@
 #include <linux/usb/ch9.h>
 #include <linux/usb/gadget.h>
 #include <linux/usb/composite.h>
+#include <linux/math64.h>
 
 #include <asm/io.h>
 #include <g_dnl.h>
@@ -76,6 +77,8 @@ struct hid_report {
 
 #define SDP_COMMAND_LEN		16
 
+#define SDP_CTRLC_POLLS		256
+
 struct sdp_command {
 	u16 cmd;
 	u32 addr;
@@ -109,6 +112,7 @@ struct f_sdp {
 	u32				dnl_address;
 	u32				dnl_bytes;
 	u32				dnl_bytes_remaining;
+	ulong				dnl_start;
 	u32				jmp_address;
 	bool				always_send_status;
 	u32				error_status;
@@ -325,6 +329,7 @@ static void sdp_rx_command_complete(struct usb_ep *ep, struct usb_request *req)
 
 		printf("Downloading file of size %d to 0x%08x... ",
 		       sdp->dnl_bytes_remaining, sdp->dnl_address);
+		sdp->dnl_start = get_timer(0);
 
 		if (stream_ops && stream_ops->new_file) {
 			stream_ops->new_file(sdp->dnl_address,
@@ -409,7 +414,16 @@ static void sdp_rx_data_complete(struct usb_ep *ep, struct usb_request *req)
 #ifndef CONFIG_SPL_BUILD
 	env_set_hex("filesize", sdp->dnl_bytes);
 #endif
-	printf("done\n");
+	if (sdp->state == SDP_STATE_RX_FILE_DATA) {
+		ulong elapsed = get_timer(sdp->dnl_start);
+		u64 kib_ms = ((u64)sdp->dnl_bytes * 1000) >> 10;
+
+		/* Show throughput in KiB/s */
+		printf("done (%lu ms, %lu KiB/s)\n", elapsed,
+		       elapsed ? (ulong)div_u64(kib_ms, elapsed) : 0);
+	} else {
+		printf("done\n");
+	}
 
 	switch (sdp->state) {
 	case SDP_STATE_RX_FILE_DATA:
@@ -858,12 +872,19 @@ void sdp_handle(int controller_index,
 		const struct sdp_stream_ops *ops, bool single)
 {
 	enum sdp_state last_state = SDP_STATE_IDLE;
+	unsigned int polls = 0;
 
 	stream_ops = ops;
 
 	printf("SDP: handle requests...\n");
 	while (1) {
-		if (ctrlc()) {
+		/*
+		 * Asking the console for CTRL-C on every poll delays the next
+		 * data report considerably. So while receiving file data,
+		 * only check every SDP_CTRLC_POLLS polls.
+		 */
+		if (((sdp_func->state != SDP_STATE_RX_FILE_DATA)
+		     || !(++polls % SDP_CTRLC_POLLS)) && ctrlc()) {
 			puts("\rCTRL+C - Operation aborted.\n");
 			return;
 		}
@@ -209,8 +209,11 @@ static inline int write_env(struct mmc *mmc, unsigned long size,
 	blk_cnt		= ALIGN(size, mmc->write_bl_len) / mmc->write_bl_len;
 
 	n = blk_dwrite(desc, blk_start, blk_cnt, (u_char *)buffer);
+	if (n != blk_cnt)
+		return -1;
 
-	return (n == blk_cnt) ? 0 : -1;
+	/* The environment must survive an immediate reset */
+	return mmc_flush_cache(mmc) ? -1 : 0;
 }
 
 static int env_mmc_save(void)
@@ -38,6 +38,16 @@
 #define CONFIG_SYS_FAT_PRELOAD_FAT 3072
 #endif
 
+/* Number of files whose cluster chains are kept in the extent cache */
+#define FAT_CHAINS		4
+
+/* Number of extents (runs of consecutive clusters) cached per file */
+#define FAT_CHAIN_EXTENTS	64
+
+/* Number of directories with a name index and hash buckets per index */
+#define FAT_INDEXES		4
+#define FAT_INDEX_HASH		256
+
 #define DOS_BOOT_MAGIC_OFFSET	0x1fe
 
 #define TO_FAT_DIRINFO(wdi)	((struct fat_dirinfo *)wdi)
@@ -57,10 +67,56 @@ struct fat_dirinfo {
 	__u32 preload_count;		/* Number of preloaded sectors */
 };
 
+/* A run of consecutive clusters of a file */
+struct fat_extent {
+	__u32 cluster;			/* First cluster of the run */
+	__u32 count;			/* Number of clusters in the run */
+};
+
+/* Cluster chain of a file as a list of extents; the extents are added when
+   the file is read and may also be shorter than the actual run on the
+   device if only a part of the file was needed. */
+struct fat_chain {
+	__u32 start;			/* Start cluster of file, 0: unused */
+	__u32 used;			/* Number of valid extents */
+	__u32 age;			/* Time of last use (for LRU) */
+	struct fat_extent ext[FAT_CHAIN_EXTENTS];
+};
+
+/* Entry of a directory name index */
+struct fat_index_entry {
+	__u32 hash;			/* Hash value of the name */
+	int next;			/* Next entry in hash bucket, -1: end */
+	unsigned int name;		/* Offset of name in name pool */
+	__u32 reference;		/* Start cluster */
+	__u32 file_size;		/* File size */
+	enum wc_file_type file_type;	/* File type */
+};
+
+/* Name index of a directory; it is built when a file name without wildcards
+   is looked up in this directory for the first time. */
+struct fat_index {
+	unsigned long reference;	/* Directory reference, 0: root dir */
+	__u32 age;			/* Time of last use (for LRU) */
+	unsigned int count;		/* Number of entries, 0: unused */
+	struct fat_index_entry *entries;
+	char *names;			/* Name pool */
+	int head[FAT_INDEX_HASH];	/* First entry per bucket, -1: empty */
+};
+
 static struct blk_desc *cur_dev;
 static unsigned int cur_part_nr;
 static struct disk_partition cur_part_info;
 
+/*
+ * Extent cache and name indexes; they are only valid for the current mount,
+ * i.e. until the next call of fat_set_blk_dev().
+ */
+static struct fat_chain fat_chains[FAT_CHAINS];
+static __u32 fat_chain_age;
+static struct fat_index fat_indexes[FAT_INDEXES];
+static __u32 fat_index_age;
+
 /* Device specific data; if we allow parallel access to more than one FAT
    device in the future, we must allocate this dynamically. The following
    dir_buffer and fat_buffer are also part of the device data */
@@ -293,6 +349,99 @@ static __u32 get_fatent(struct fsdata *mydata, __u32 cluster)
 }
 
 
+/**
+ * fat_flush_chains() - Invalidate the extent cache
+ */
+static void fat_flush_chains(void)
+{
+	memset(fat_chains, 0, sizeof(fat_chains));
+	fat_chain_age = 0;
+}
+
+/**
+ * fat_get_chain() - Get the cached cluster chain of a file
+ * @start: Start cluster of the file
+ *
+ * Return the cached cluster chain of the file. If the file is not in the
+ * cache yet, replace the least recently used entry.
+ *
+ * Return:
+ * Pointer to the cluster chain
+ */
+static struct fat_chain *fat_get_chain(__u32 start)
+{
+	struct fat_chain *fc;
+	struct fat_chain *oldest = &fat_chains[0];
+	int i;
+
+	fat_chain_age++;
+	for (i = 0; i < FAT_CHAINS; i++) {
+		fc = &fat_chains[i];
+		if (fc->used && (fc->start == start)) {
+			fc->age = fat_chain_age;
+			return fc;
+		}
+		if (fc->age < oldest->age)
+			oldest = fc;
+	}
+
+	oldest->start = start;
+	oldest->used = 0;
+	oldest->age = fat_chain_age;
+
+	return oldest;
+}
+
+/**
+ * fat_next_extent() - Get the next run of consecutive clusters of a file
+ * @mydata: Pointer to device specific information
+ * @fc:     Pointer to the cluster chain of the file
+ * @index:  Index of the extent to get
+ * @max:    Maximum number of clusters that are needed
+ * @ext:    Pointer to extent; on entry, this must hold extent index-1
+ *
+ * If the extent is already cached, simply return it. Otherwise follow the
+ * FAT behind the previous extent and collect up to max consecutive clusters.
+ * If there is room in the cache, the new extent is added there.
+ *
+ * Return:
+ *  0 - OK, next extent is in ext;
+ * -1 - Unexpected EOF, invalid cluster or error reading the FAT
+ */
+static int fat_next_extent(struct fsdata *mydata, struct fat_chain *fc,
+			   __u32 index, __u32 max, struct fat_extent *ext)
+{
+	__u32 cluster;
+
+	if (index < fc->used) {
+		*ext = fc->ext[index];
+		return 0;
+	}
+
+	if (!index)
+		cluster = fc->start;
+	else
+		cluster = get_fatent(mydata, ext->cluster + ext->count - 1);
+	if ((cluster < 2) || (cluster >= mydata->max_cluster))
+		return -1;
+
+	ext->cluster = cluster;
+	ext->count = 1;
+	while (ext->count < max) {
+		if (get_fatent(mydata, cluster) != cluster + 1)
+			break;
+		cluster++;
+		ext->count++;
+	}
+
+	if ((index == fc->used) && (index < FAT_CHAIN_EXTENTS)) {
+		fc->ext[index] = *ext;
+		fc->used++;
+	}
+
+	return 0;
+}
+
 /**
  * fat_dir_preload() - Load the next chunk of the directory
  * @mydata: Pointer to device specific information
@@ -510,6 +659,222 @@ static int fat_get_fileinfo(struct wc_dirinfo *wdi, struct wc_fileinfo *wfi)
 	return 1;
 }
 
+/**
+ * fat_name_hash() - Compute hash value of a file name
+ * @name: File name
+ *
+ * Return:
+ * Hash value
+ */
+static __u32 fat_name_hash(const char *name)
+{
+	__u32 hash = 5381;
+
+	while (*name)
+		hash = hash * 33 + (unsigned char)*name++;
+
+	return hash;
+}
+
+/**
+ * fat_free_index() - Release the data of a directory name index
+ * @fix: Pointer to directory name index
+ */
+static void fat_free_index(struct fat_index *fix)
+{
+	free(fix->entries);
+	free(fix->names);
+	fix->entries = NULL;
+	fix->names = NULL;
+	fix->count = 0;
+}
+
+/**
+ * fat_flush_indexes() - Invalidate all directory name indexes
+ */
+static void fat_flush_indexes(void)
+{
+	int i;
+
+	for (i = 0; i < FAT_INDEXES; i++)
+		fat_free_index(&fat_indexes[i]);
+	fat_index_age = 0;
+}
+
+/**
+ * fat_build_index() - Build the name index of a directory
+ * @wdi: Pointer to directory entry
+ * @fix: Pointer to (empty) directory name index
+ *
+ * Scan the whole directory once and add all entries except "." and ".." to
+ * the index. The directory is rewound afterwards.
+ *
+ * Return:
+ *  0 - OK, index is built;
+ * -1 - Error while reading data from device or out of memory
+ */
+static int fat_build_index(struct wc_dirinfo *wdi, struct fat_index *fix)
+{
+	struct wc_fileinfo wfi;
+	struct fat_index_entry *fie;
+	unsigned int max_entries = 0;
+	unsigned int names_size = 0;
+	unsigned int names_used = 0;
+	unsigned int len;
+	void *p;
+	int ret;
+	int i;
+
+	for (i = 0; i < FAT_INDEX_HASH; i++)
+		fix->head[i] = -1;
+	fix->reference = wdi->reference;
+
+	wdi->flags |= WC_FLAGS_REWIND;
+	while ((ret = fat_get_fileinfo(wdi, &wfi)) > 0) {
+		if (!strcmp(wfi.file_name, ".")
+		    || !strcmp(wfi.file_name, ".."))
+			continue;
+
+		/* Grow entry array and name pool if necessary */
+		if (fix->count >= max_entries) {
+			max_entries = max_entries ? 2 * max_entries : 64;
+			p = realloc(fix->entries,
+				    max_entries * sizeof(*fix->entries));
+			if (!p)
+				break;
+			fix->entries = p;
+		}
+		len = strlen(wfi.file_name) + 1;
+		if (names_used + len > names_size) {
+			names_size = names_size ? 2 * names_size : 2048;
+			p = realloc(fix->names, names_size);
+			if (!p)
+				break;
+			fix->names = p;
+		}
+
+		fie = &fix->entries[fix->count];
+		fie->hash = fat_name_hash(wfi.file_name);
+		fie->name = names_used;
+		fie->reference = wfi.reference;
+		fie->file_size = (__u32)wfi.file_size;
+		fie->file_type = wfi.file_type;
+		i = fie->hash % FAT_INDEX_HASH;
+		fie->next = fix->head[i];
+		fix->head[i] = fix->count++;
+		memcpy(fix->names + names_used, wfi.file_name, len);
+		names_used += len;
+	}
+	wdi->flags |= WC_FLAGS_REWIND;
+
+	/* An empty directory still gets a (dummy) entry to mark it valid */
+	if (!ret && !fix->count) {
+		fix->entries = malloc(sizeof(*fix->entries));
+		if (fix->entries) {
+			fix->entries->hash = 0;
+			fix->entries->next = -1;
+			fix->entries->name = 0;
+			fix->entries->file_type = WC_TYPE_NONE;
+			fix->count = 1;
+		}
+	}
+	if (ret || !fix->count) {
+		fat_free_index(fix);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * fat_get_index() - Get the name index of a directory
+ * @wdi: Pointer to directory entry
+ *
+ * Return the name index of the directory. If the directory is not indexed
+ * yet, replace the least recently used index and build a new one.
+ *
+ * Return:
+ * Pointer to the name index, NULL on error
+ */
+static struct fat_index *fat_get_index(struct wc_dirinfo *wdi)
+{
+	struct fat_index *fix;
+	struct fat_index *oldest = &fat_indexes[0];
+	int i;
+
+	fat_index_age++;
+	for (i = 0; i < FAT_INDEXES; i++) {
+		fix = &fat_indexes[i];
+		if (fix->count && (fix->reference == wdi->reference)) {
+			fix->age = fat_index_age;
+			return fix;
+		}
+		if (fix->age < oldest->age)
+			oldest = fix;
+	}
+
+	fat_free_index(oldest);
+	oldest->age = fat_index_age;
+	if (fat_build_index(wdi, oldest))
+		return NULL;
+
+	return oldest;
+}
+
+/**
+ * fat_find_file() - Look up a file by its exact name
+ * @wdi:  Pointer to directory entry
+ * @wfi:  Pointer to structure where to store file information
+ * @name: File name to search for (no wildcards)
+ *
+ * Look up the file with the given name in the name index of the directory.
+ * If the index can not be built (out of memory), search the directory
+ * linearly instead.
+ *
+ * Return:
+ *  1 - OK, found the file;
+ *  0 - There is no such file;
+ * -1 - Error while reading data from device
+ */
+static int fat_find_file(struct wc_dirinfo *wdi, struct wc_fileinfo *wfi,
+			 const char *name)
+{
+	struct fat_index *fix;
+	struct fat_index_entry *fie;
+	__u32 hash;
+	int i;
+	int ret;
+
+	fix = fat_get_index(wdi);
+	if (!fix) {
+		/* No index, do a linear search */
+		wdi->flags |= WC_FLAGS_REWIND;
+		while ((ret = fat_get_fileinfo(wdi, wfi)) > 0) {
+			if (!strcmp(wfi->file_name, name))
+				break;
+		}
+		wdi->flags |= WC_FLAGS_REWIND;
+
+		return ret;
+	}
+
+	hash = fat_name_hash(name);
+	for (i = fix->head[hash % FAT_INDEX_HASH]; i >= 0; i = fie->next) {
+		fie = &fix->entries[i];
+		if ((fie->hash == hash) && !strcmp(fix->names + fie->name, name))
+			break;
+	}
+	if (i < 0)
+		return 0;
+
+	strcpy(wfi->file_name, fix->names + fie->name);
+	wfi->reference = fie->reference;
+	wfi->file_size = (loff_t)fie->file_size;
+	wfi->file_type = fie->file_type;
+
+	return 1;
+}
+
 /**
  * fat_read_at() - Read the file
  * @wdi:     Pointer to current directory entry
@@ -519,7 +884,10 @@ static int fat_get_fileinfo(struct wc_dirinfo *wdi, struct wc_fileinfo *wfi)
  * @len:     Maximum number of bytes to read (0: whole/remaining file)
  * @actread: Number of actually read bytes
  *
- * Read the file given in wfistarting at cluster wfi->reference.
+ * Read the file given in wfistarting at cluster wfi->reference. The cluster
+ * chain is taken from the extent cache, so each run of consecutive clusters
+ * is loaded with one large read and skipping data at the beginning of the
+ * file does not need to follow the FAT again.
  *
  * ATTENTION: We are re-using the directory preload buffer here. This should
  * be no problem as long as we don't require the directory content anymore.
@@ -537,8 +905,9 @@ static int fat_read_at(struct wc_dirinfo *wdi, struct wc_fileinfo *wfi,
 	unsigned long bytes_per_cluster;
 	unsigned long sect_size;
 	int warning = 0;
-	__u32 cluster;
-	__u32 tmp;
+	struct fat_chain *fc;
+	struct fat_extent ext;
+	__u32 index;
 	__u32 sector_count;
 	__u32 sector;
 
@@ -554,28 +923,22 @@ static int fat_read_at(struct wc_dirinfo *wdi, struct wc_fileinfo *wfi,
 
 	sect_size = mydata->sect_size;
 	bytes_per_cluster = mydata->clust_size * sect_size;
-	cluster = wfi->reference;
+	fc = fat_get_chain(wfi->reference);
+	index = 0;
 
 	do {
-		/* Combine sectors to a long chunk if they are in sequence */
-		sector = clust2sect(mydata, cluster);
-		bytes_next_chunk = 0;
-		do {
-			if (remaining <= bytes_per_cluster) {
-				bytes_next_chunk += remaining;
-				remaining = 0;
-				break;
-			}
-			bytes_next_chunk += bytes_per_cluster;
-			remaining -= bytes_per_cluster;
-
-			tmp = cluster;
-			cluster = get_fatent(mydata, cluster);
-
-			/* Return on unexpected EOF or invalid cluster */
-			if ((cluster < 2) || (cluster >= mydata->max_cluster))
-				goto out;
-		} while (cluster == tmp + 1);
+		__u32 clusters;
+
+		/* Get the next run of consecutive clusters; return on
+		   unexpected EOF or invalid cluster */
+		clusters = (remaining - 1) / bytes_per_cluster + 1;
+		if (fat_next_extent(mydata, fc, index++, clusters, &ext))
+			goto out;
+		sector = clust2sect(mydata, ext.cluster);
+		bytes_next_chunk = ext.count * bytes_per_cluster;
+		if (bytes_next_chunk > remaining)
+			bytes_next_chunk = remaining;
+		remaining -= bytes_next_chunk;
 
 		debug("Next chunk: 0x%lx bytes at sector 0x%x\n",
 		      bytes_next_chunk, sector);
@@ -631,22 +994,29 @@ static int fat_read_at(struct wc_dirinfo *wdi, struct wc_fileinfo *wfi,
 			      sector);
 			if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1)) {
 				void *temp = mydata->dirbuf;
-				__u32 i;
+				__u32 max = CONFIG_SYS_FAT_PRELOAD_DIR / sect_size;
 
-				/* Read sectors with single reads */
+				/* Read sectors through the preload buffer */
 				if (!warning) {
 					puts("Buffer unaligned, using slow"
-					     " single-sector reads\n");
+					     " buffered reads\n");
 					warning = 1;
 				}
-				for (i = 0; i < sector_count; i++) {
-					if (disk_read(sector, 1, temp) != 1)
+				while (sector_count) {
+					__u32 count = sector_count;
+					unsigned long bytes;
+
+					if (count > max)
+						count = max;
+					if (disk_read(sector, count, temp) != count)
 						goto out;
-					sector++;
-					memcpy(buffer, temp, sect_size);
-					buffer += sect_size;
-					total_bytes_loaded += sect_size;
-					bytes_next_chunk -= sect_size;
+					bytes = count * sect_size;
+					memcpy(buffer, temp, bytes);
+					sector += count;
+					sector_count -= count;
+					buffer += bytes;
+					total_bytes_loaded += bytes;
+					bytes_next_chunk -= bytes;
 				}
 			} else {
 				unsigned long bytes_loaded;
@@ -702,7 +1072,8 @@ const struct wc_fsops fat_ops = {
 #else
 	NULL,
 #endif
-	NULL
+	NULL,
+	fat_find_file
 };
 
 /**
@@ -796,6 +1167,14 @@ int fat_set_blk_dev(struct blk_desc *dev_desc, struct disk_partition *info)
 	struct fsdata *mydata = &myfsdata;
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, buffer, dev_desc->blksz);
 
+	/*
+	 * The medium may have been changed behind our back in the meantime,
+	 * e.g. by raw block writes or by a USB host in ums, so do not trust
+	 * any cached data from a previous mount.
+	 */
+	fat_flush_chains();
+	fat_flush_indexes();
+
 	cur_dev = dev_desc;
 	cur_part_info = *info;
 
@@ -17,6 +17,7 @@
 #include <ext4fs.h>
 #include <fat.h>
 #include <fs.h>
+#include <gzip.h>
 #include <sandboxfs.h>
 #include <ubifs_uboot.h>
 #include <btrfs.h>
@@ -773,6 +774,140 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	return 0;
 }
 
+#ifdef CONFIG_GZIP
+struct fs_gzload_info {
+	struct fstype_info *info;
+	const char *filename;
+	loff_t pos;
+	loff_t remaining;
+};
+
+/*
+ * Read the next chunk of the compressed file. The filesystem stays mounted
+ * for the whole transfer, so unlike _fs_read() this neither closes nor
+ * probes it again and the fs driver can continue where the last chunk ended.
+ */
+static int fs_gzload_read(void *priv, unsigned char *buf, ulong size)
+{
+	struct fs_gzload_info *gi = priv;
+	loff_t len_read;
+
+	if (size > gi->remaining)
+		size = gi->remaining;
+	if (!size)
+		return 0;
+
+	if (gi->info->read(gi->filename, buf, gi->pos, size, &len_read) < 0)
+		return -1;
+	gi->pos += len_read;
+	gi->remaining -= len_read;
+
+	return len_read;
+}
+
+/* Get the number of bytes that may be uncompressed to addr */
+static ulong fs_gzload_maxsize(ulong addr)
+{
+#ifdef CONFIG_LMB
+	struct lmb lmb;
+
+	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+	lmb_dump_all(&lmb);
+
+	return min(lmb_get_free_size(&lmb, addr), (phys_size_t)INT_MAX);
+#elif defined(CONFIG_SYS_BOOTM_LEN)
+	return CONFIG_SYS_BOOTM_LEN;
+#else
+	return INT_MAX;
+#endif
+}
+
+int do_gzload(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
+	      int fstype)
+{
+	struct fs_gzload_info gi;
+	unsigned long addr;
+	unsigned long maxsize;
+	unsigned long limit;
+	void *buf;
+	unsigned long len;
+	unsigned long time;
+	loff_t size;
+	int ret;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+	if (argc > 6)
+		return CMD_RET_USAGE;
+
+	if (fs_set_blk_dev(argv[1], (argc >= 3) ? argv[2] : NULL, fstype)) {
+		log_err("Can't set block device\n");
+		return 1;
+	}
+
+	if (argc >= 4)
+		addr = parse_loadaddr(argv[3], NULL);
+	else
+		addr = get_loadaddr();
+	if (argc >= 5)
+		gi.filename = env_parse_bootfile(argv[4]);
+	else
+		gi.filename = env_get_bootfile();
+	if (!gi.filename) {
+		fs_close();
+		puts("** No boot file defined **\n");
+		return 1;
+	}
+	limit = fs_gzload_maxsize(addr);
+	if (!limit) {
+		fs_close();
+		log_err("** Loading file would overwrite reserved memory **\n");
+		return 1;
+	}
+	if (argc >= 6)
+		maxsize = simple_strtoul(argv[5], NULL, 16);
+	else
+		maxsize = 0;
+	if (!maxsize || (maxsize > limit))
+		maxsize = limit;
+
+	gi.info = fs_get_info(fs_type);
+	if (gi.info->size(gi.filename, &size) < 0) {
+		fs_close();
+		log_err("Failed to load '%s'\n", gi.filename);
+		return 1;
+	}
+	gi.pos = 0;
+	gi.remaining = size;
+
+	set_fileaddr(addr);
+
+	buf = map_sysmem(addr, maxsize);
+	time = get_timer(0);
+	ret = gunzip_stream(buf, maxsize, fs_gzload_read, &gi, &len);
+	time = get_timer(time);
+	unmap_sysmem(buf);
+	fs_close();
+	if (ret) {
+		log_err("Failed to load '%s'\n", gi.filename);
+		return 1;
+	}
+
+	printf("%llu bytes read, %lu bytes uncompressed in %lu ms", gi.pos,
+	       len, time);
+	if (time > 0) {
+		puts(" (");
+		print_size(div_u64(len, time) * 1000, "/s");
+		puts(")");
+	}
+	puts("\n");
+
+	env_set_fileinfo(len);
+
+	return 0;
+}
+#endif /* CONFIG_GZIP */
+
 int do_ls(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	  int fstype)
 {
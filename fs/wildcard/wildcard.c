@@ -119,6 +119,72 @@ static int wildcard_find_file(struct wc_dirinfo *wdi, struct wc_fileinfo *wfi)
 	return ret;
 }
 
+/**
+ * wildcard_is_literal() - Check if the next pattern part has no wildcards
+ * @pattern: Pattern to check
+ *
+ * Check if the part of the pattern up to the next directory delimiter has no
+ * wildcards '*' and '?', so that it can be looked up directly by name. This
+ * requires that the filesystem provides a find_file() function.
+ *
+ * Return:
+ * 1 if the name can be looked up directly, 0 if not.
+ */
+static int wildcard_is_literal(const char *pattern)
+{
+	char c;
+
+	if (!fs_ops->find_file)
+		return 0;
+
+	while ((c = *pattern++) && (c != '/')) {
+		if ((c == '*') || (c == '?'))
+			return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * wildcard_find_name() - Look up a file name without wildcards
+ * @wdi:    Directory entry; wdi->dir_pattern is the name to search for
+ * @wfi:    Structure where to store file information if the file is found
+ *
+ * Look up the name in wdi->dir_pattern (up to the next directory delimiter)
+ * with the find_file() function of the filesystem. There can only be one
+ * match, so the result is always unique. The directory is rewound
+ * afterwards.
+ *
+ * Return:
+ *  1 - Found the file;
+ *  0 - No such file;
+ * -1 - Error, e.g. while reading data from the device
+ */
+static int wildcard_find_name(struct wc_dirinfo *wdi, struct wc_fileinfo *wfi)
+{
+	const char *pattern = wdi->dir_pattern;
+	char name[WC_NAME_MAX];
+	unsigned int len;
+	int ret;
+
+	len = strchrnul(pattern, '/') - pattern;
+	if (len >= WC_NAME_MAX)
+		return 0;
+	memcpy(name, pattern, len);
+	name[len] = '\0';
+
+	/* Dummy directories . and .. should never match */
+	if (!strcmp(name, ".") || !strcmp(name, ".."))
+		return 0;
+
+	ret = fs_ops->find_file(wdi, wfi, name);
+	if (ret > 0)
+		wfi->pattern = pattern + len;
+	wdi->flags |= WC_FLAGS_REWIND;
+
+	return ret;
+}
+
 /**
  * wildcard_find_dir() - Return next directory match for a pattern
  * @wdi:    Directory entry; wdi->dir_pattern is the pattern to search for
@@ -451,7 +517,26 @@ static struct wc_dirinfo *wildcard_find_unique(struct wc_fileinfo *wfi)
 			return wildcard_path_done(wdi);
 		}
 
-		if (!strchr(wdi->dir_pattern, '/')) {
+		if (wildcard_is_literal(wdi->dir_pattern)) {
+			/* No wildcards, look up the name directly; if this
+			   is not the final file name, it must be a directory */
+			ret = wildcard_find_name(wdi, wfi);
+			if (!strchr(wdi->dir_pattern, '/')) {
+				if (ret == 1)
+					return wdi;
+				if (ret == 0) {
+					/* Final file does not exist */
+					wfi->file_type = WC_TYPE_NONE;
+					wfi->file_name[0] = '\0';
+					wfi->pattern = wdi->dir_pattern;
+					wfi->reference = 0;
+					return wdi;
+				}
+			} else if ((ret == 1)
+				   && (wfi->file_type != WC_TYPE_DIRECTORY)) {
+				ret = 0;
+			}
+		} else if (!strchr(wdi->dir_pattern, '/')) {
 			/* No more directory delimiter in the path. So the
 			   path exists and is unique, now check file name.
 			   Here all file types are allowed to match. */
@@ -526,7 +611,21 @@ int wildcard_ls(struct wc_fileinfo *wfi, const struct wc_fsops *ops)
 				break;
 			}
 
-			if (!strchr(wdi->dir_pattern, '/')) {
+			if (wildcard_is_literal(wdi->dir_pattern)) {
+				/* No wildcards, look up the name directly;
+				   there is at most one match, so do not look
+				   for further matches when coming back */
+				ret = wildcard_find_name(wdi, wfi);
+				if ((ret == 1)
+				    && (wfi->file_type != WC_TYPE_DIRECTORY))
+					ret = 0;
+				if (!ret && !strchr(wdi->dir_pattern, '/')) {
+					/* No directory, list matching file */
+					wildcard_list_dir(wdi, wfi);
+					break;
+				}
+				wdi->flags |= WC_FLAGS_UNIQUE;
+			} else if (!strchr(wdi->dir_pattern, '/')) {
 				/* We are at the final part of the path, the
 				   file name. If we match exactly one file and
 				   if this file is a directory, open it as
@@ -558,8 +657,12 @@ int wildcard_ls(struct wc_fileinfo *wfi, const struct wc_fsops *ops)
 				wdi = wildcard_free_dir(wdi);
 				if (!wdi)
 					return 0; /* Done */
-				wdi->flags |= WC_FLAGS_RELOAD;
-				ret = wildcard_find_dir(wdi, wfi);
+				if (wdi->flags & WC_FLAGS_UNIQUE)
+					ret = 0;
+				else {
+					wdi->flags |= WC_FLAGS_RELOAD;
+					ret = wildcard_find_dir(wdi, wfi);
+				}
 			} while (!ret);
 		}
 	} while (ret >= 0);
@@ -8,6 +8,7 @@
 #define BLK_H
 
 #include <efi.h>
+#include <linux/list.h>
 
 #ifdef CONFIG_SYS_64BIT_LBA
 typedef uint64_t lbaint_t;
@@ -136,6 +137,25 @@ int blkcache_read(int iftype, int dev,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer);
 
+/**
+ * blkcache_readahead() - get the number of blocks to read ahead on a miss
+ *
+ * Sequential misses on a device grow the read-ahead window, any other
+ * access resets it. The caller should read the returned number of blocks
+ * in addition to the requested ones and pass all of them to
+ * blkcache_fill().
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number of the missed read
+ * @param blkcnt - number of blocks of the missed read
+ * @param limit - number of blocks available after start + blkcnt
+ *
+ * @return - number of blocks to read after start + blkcnt, may be 0
+ */
+lbaint_t blkcache_readahead(int iftype, int dev,
+			    lbaint_t start, lbaint_t blkcnt, lbaint_t limit);
+
 /**
  * blkcache_fill() - make data read from a block device available
  * to the block cache
@@ -165,9 +185,9 @@ void blkcache_invalidate(int iftype, int dev);
  * blkcache_configure() - configure block cache
  *
  * @param blocks - maximum blocks per entry
- * @param entries - maximum entries in cache
+ * @param bytes - maximum size of all cached data in bytes
  */
-void blkcache_configure(unsigned blocks, unsigned entries);
+void blkcache_configure(unsigned blocks, unsigned long bytes);
 
 /*
  * statistics of the block cache
@@ -175,18 +195,46 @@ void blkcache_configure(unsigned blocks, unsigned entries);
 struct block_cache_stats {
 	unsigned hits;
 	unsigned misses;
+	unsigned evictions;
 	unsigned entries; /* current entry count */
+	unsigned long bytes; /* current size of cached data */
 	unsigned max_blocks_per_entry;
-	unsigned max_entries;
+	unsigned long max_bytes;
+};
+
+/*
+ * statistics of the block cache for one device
+ */
+struct block_cache_dev_stats {
+	int iftype;
+	int devnum;
+	unsigned hits;
+	unsigned misses;
+	unsigned evictions;
+	unsigned readahead; /* blocks read ahead */
 };
 
 /**
  * get_blkcache_stats() - return statistics and reset
  *
+ * This also resets the counters of all devices.
+ *
  * @param stats - statistics are copied here
  */
 void blkcache_stats(struct block_cache_stats *stats);
 
+/**
+ * blkcache_dev_stats() - return statistics of one device
+ *
+ * The counters are not reset, call blkcache_stats() afterwards for this.
+ *
+ * @param index - index of the device in the cache, starting with 0
+ * @param stats - statistics are copied here
+ *
+ * @return - 0 on success, -ENOENT if there is no device with this index
+ */
+int blkcache_dev_stats(int index, struct block_cache_dev_stats *stats);
+
 #else
 
 static inline int blkcache_read(int iftype, int dev,
@@ -196,6 +244,13 @@ static inline int blkcache_read(int iftype, int dev,
 	return 0;
 }
 
+static inline lbaint_t blkcache_readahead(int iftype, int dev,
+					  lbaint_t start, lbaint_t blkcnt,
+					  lbaint_t limit)
+{
+	return 0;
+}
+
 static inline void blkcache_fill(int iftype, int dev,
 				 lbaint_t start, lbaint_t blkcnt,
 				 unsigned long blksz, void const *buffer) {}
@@ -207,6 +262,39 @@ static inline void blkcache_invalidate(int iftype, int dev) {}
 #if CONFIG_IS_ENABLED(BLK)
 struct udevice;
 
+/* Maximum number of asynchronous requests per block device */
+#define BLK_ASYNC_QUEUE_DEPTH	32
+
+/**
+ * struct blk_req - an asynchronous block device request
+ *
+ * The request is owned by the caller and must stay valid until it has
+ * completed, i.e. until blk_req_poll() returned something other than
+ * -EINPROGRESS.
+ *
+ * @desc:	Block device of the request
+ * @start:	Start block number (0=first)
+ * @blkcnt:	Number of blocks to transfer
+ * @buffer:	Buffer for the data to read or write
+ * @write:	true for a write request, false for a read request
+ * @result:	-EINPROGRESS while the request is pending, otherwise the
+ *		number of blocks transferred, or -ve error number
+ * @node:	Entry in the queue of the device (internal use)
+ * @wgen:	Write generation of the queue at submit time (internal use)
+ * @priv:	Free for use by the driver while the request is active
+ */
+struct blk_req {
+	struct blk_desc *desc;
+	lbaint_t start;
+	lbaint_t blkcnt;
+	void *buffer;
+	bool write;
+	long result;
+	struct list_head node;
+	uint wgen;
+	ulong priv;
+};
+
 /* Operations on block devices */
 struct blk_ops {
 	/**
@@ -265,6 +353,37 @@ struct blk_ops {
 	 * @return 0 if OK, -ve on error
 	 */
 	int (*select_hwpart)(struct udevice *dev, int hwpart);
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/**
+	 * submit() - start an asynchronous read or write request
+	 *
+	 * This is optional. The driver starts the transfer and returns
+	 * without waiting for it to complete. Requests are submitted in
+	 * the order they were queued and a driver that can not accept
+	 * another request right now returns -EBUSY; the request is then
+	 * submitted again after an earlier one has completed. If the
+	 * driver can not handle this request asynchronously at all, it
+	 * returns -ENOSYS and the request is done with read() or write().
+	 *
+	 * @dev:	Device to read from or write to
+	 * @req:	Request to start
+	 * @return 0 if OK, -EBUSY or -ENOSYS (see above), other -ve error
+	 */
+	int (*submit)(struct udevice *dev, struct blk_req *req);
+
+	/**
+	 * poll() - check whether a submitted request is complete
+	 *
+	 * This must not wait for the transfer to complete.
+	 *
+	 * @dev:	Device the request was submitted to
+	 * @req:	Request to check
+	 * @return -EINPROGRESS if the request is still active, otherwise
+	 * the number of blocks transferred, or -ve error number
+	 */
+	long (*poll)(struct udevice *dev, struct blk_req *req);
+#endif
 };
 
 #define blk_get_ops(dev)	((struct blk_ops *)(dev)->driver->ops)
@@ -282,6 +401,69 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt);
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/**
+ * blk_dread_async() - start reading from a block device
+ *
+ * The request is queued to the device and the function returns without
+ * waiting for the data. Use blk_req_poll() or blk_req_wait() to check for
+ * completion. Requests of one device are started in the order they were
+ * submitted. If the driver has no support for asynchronous requests, the
+ * data is read immediately and the request is already complete on return.
+ *
+ * @block_dev:	Block device to read from
+ * @start:	Start block number to read (0=first)
+ * @blkcnt:	Number of blocks to read
+ * @buffer:	Destination buffer for data read
+ * @req:	Request structure to use, owned by the caller
+ * @return 0 if OK, -EBUSY if BLK_ASYNC_QUEUE_DEPTH requests are already
+ * pending on this device, other -ve error
+ */
+int blk_dread_async(struct blk_desc *block_dev, lbaint_t start,
+		    lbaint_t blkcnt, void *buffer, struct blk_req *req);
+
+/**
+ * blk_dwrite_async() - start writing to a block device
+ *
+ * This is the same as blk_dread_async(), but for writing.
+ *
+ * @block_dev:	Block device to write to
+ * @start:	Start block number to write (0=first)
+ * @blkcnt:	Number of blocks to write
+ * @buffer:	Source buffer for data to write, must not be modified until
+ *		the request is complete
+ * @req:	Request structure to use, owned by the caller
+ * @return 0 if OK, -EBUSY if BLK_ASYNC_QUEUE_DEPTH requests are already
+ * pending on this device, other -ve error
+ */
+int blk_dwrite_async(struct blk_desc *block_dev, lbaint_t start,
+		     lbaint_t blkcnt, const void *buffer, struct blk_req *req);
+
+/**
+ * blk_req_poll() - check for completion of an asynchronous request
+ *
+ * This also advances the queue of the device, i.e. completed requests are
+ * retired and waiting requests are handed to the driver.
+ *
+ * @req:	Request to check
+ * @return -EINPROGRESS if the request is still pending, otherwise the
+ * number of blocks transferred, or -ve error number
+ */
+long blk_req_poll(struct blk_req *req);
+
+/**
+ * blk_req_wait() - wait for completion of an asynchronous request
+ *
+ * If the request does not complete within 10 seconds, it is removed from the
+ * queue and -ETIMEDOUT is returned. The driver is not told about this, so
+ * the device should be reset before it is used again.
+ *
+ * @req:	Request to wait for
+ * @return number of blocks transferred, or -ve error number
+ */
+long blk_req_wait(struct blk_req *req);
+#endif
+
 /**
  * blk_find_device() - Find a block device
  *
@@ -313,6 +313,22 @@ uint32_t bootstage_accum(enum bootstage_id id);
 /* Print a report about boot time */
 void bootstage_report(void);
 
+/**
+ * bootstage_get_record() - Get name and time of a bootstage record
+ *
+ * Records are returned in the order they were added, the report functions
+ * may sort them in place, though.
+ *
+ * @index:	Index of record to get, starting at 0
+ * @buf:	Buffer to put name if record has no name
+ * @len:	Length of buffer
+ * @time_usp:	Returns the time of the mark or the accumulated time
+ * @accump:	Returns true if this is an accumulating record
+ * @return name of the record, or NULL if @index is out of range
+ */
+const char *bootstage_get_record(uint index, char *buf, int len,
+				 ulong *time_usp, bool *accump);
+
 /**
  * Add bootstage information to the device tree
  *
@@ -409,6 +425,13 @@ static inline uint32_t bootstage_accum(enum bootstage_id id)
 	return 0;
 }
 
+static inline const char *bootstage_get_record(uint index, char *buf,
+					       int len, ulong *time_usp,
+					       bool *accump)
+{
+	return NULL;
+}
+
 static inline int bootstage_stash(void *base, int size)
 {
 	return 0;	/* Pretend to succeed */
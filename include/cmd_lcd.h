@@ -85,6 +85,9 @@ typedef int XYPOS;
 /* PWM value for maximum voltage */
 #define MAX_PWM 4096
 
+/* Number of modified regions that are tracked per window */
+#define DAMAGE_RECTS 4
+
 /* These appear so often that a macro seems appropriate */
 #define lcd_set_fg(pwi, rgba) lcd_set_col(pwi, rgba, &pwi->fg)
 #define lcd_set_bg(pwi, rgba) lcd_set_col(pwi, rgba, &pwi->bg)
@@ -141,6 +144,14 @@ typedef struct PIXEL_INFO {
 #endif
 } pixinfo_t;
 
+/* Modified region of the draw buffer (in framebuffer coordinates) */
+typedef struct dmrect {
+	XYPOS x1;			  /* Top left corner */
+	XYPOS y1;
+	XYPOS x2;			  /* Bottom right corner (inclusive) */
+	XYPOS y2;
+} dmrect_t;
+
 /* Console information */
 typedef struct coninfo {
 	u_short x;			  /* Current writing position */
@@ -246,6 +257,8 @@ struct wininfo
 	XYPOS fbvres;
 	XYPOS hoffs;			  /* Offset within framebuffer (>=0) */
 	XYPOS voffs;
+	dmrect_t damage[DAMAGE_RECTS];	  /* Modified regions of fbdraw */
+	u_char damage_count;		  /* Number of used damage entries */
 
 	/* Drawing information, only accessed by draw commands */
 	colinfo_t fg;			  /* Foreground color info */
@@ -314,6 +327,13 @@ extern void console_cls(const wininfo_t *pwi, COLOR32 col);
 extern void lcd_putc(const struct stdio_dev *pdev, const char c);
 extern void lcd_puts(const struct stdio_dev *pdev, const char *s);
 
+/* Damage tracking; regions are flushed from D-cache at the end of a batch */
+extern void lcd_damage(const wininfo_t *pwi, XYPOS x1, XYPOS y1,
+		       XYPOS x2, XYPOS y2);
+extern void lcd_flush_damage(const wininfo_t *pwi);
+extern void lcd_batch_begin(void);
+extern void lcd_batch_end(void);
+
 /* Set colinfo structure */
 extern void lcd_set_col(wininfo_t *pwi, RGBA rgba, colinfo_t *pci);
 
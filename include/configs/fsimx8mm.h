@@ -36,7 +36,8 @@
  * OCRAM_S layout (SPL)
  * --------------------
  * 0x0018_0000: Copy of DRAM configuration (passed to ATF)(~16KB)
- * 0x0018_4000: --- (free)
+ * 0x0018_4000: Stacks of secondary cores in memtest (12KB)
+ * 0x0018_7000: --- (free)
  * 0x0018_7FFF: End
  *
  * After SPL, U-Boot is loaded to DRAM at 0x4020_0000. If a TEE program is
@@ -159,6 +160,10 @@
 /* malloc_f is used before GD_FLG_FULL_MALLOC_INIT set */
 #define CONFIG_MALLOC_F_ADDR 0x914000
 
+/* OCRAM_S region for the stacks of the secondary cores in SPL memtest */
+#define CONFIG_FS_SPL_MEMTEST_STACK	0x184000
+#define CONFIG_FS_SPL_MEMTEST_STACK_SIZE	0x3000	/* 12 KB */
+
 /* ### Kann das weg? Wird nirgendwo genutzt */
 #define CONFIG_SPL_ABORT_ON_RAW_IMAGE /* For RAW image gives a error info not panic */
 
@@ -34,6 +34,13 @@
  * 0x0096_8000: ATF (8MP)           ATF       (96KB) CONFIG_SPL_ATF_ADDR
  * 0x0098_FFFF: END (8MP) #####!!!!!##### (MP hat 576KB OCRAM, nicht nur 512KB)
  *
+ * OCRAM_S layout (SPL)
+ * --------------------
+ * 0x0018_0000: Copy of DRAM configuration (passed to ATF)(~16KB)
+ * 0x0018_4000: Stacks of secondary cores in memtest (12KB)
+ * 0x0018_7000: --- (free)
+ * 0x0018_8FFF: End
+ *
  * The sum of SPL and DDR_FW must not exceed 240KB (0x3C000). However there is
  * still room to extend this region if SPL grows larger in the future, e.g. by
  * letting DRAM Timing Data overlap with ATF region.
@@ -122,6 +129,10 @@
 
 #define CONFIG_MALLOC_F_ADDR		0x91A800 /* malloc f used before GD_FLG_FULL_MALLOC_INIT set */
 
+/* OCRAM_S region for the stacks of the secondary cores in SPL memtest */
+#define CONFIG_FS_SPL_MEMTEST_STACK	0x184000
+#define CONFIG_FS_SPL_MEMTEST_STACK_SIZE	0x3000	/* 12 KB */
+
 #define CONFIG_SPL_ABORT_ON_RAW_IMAGE
 
 #define CONFIG_POWER
@@ -236,6 +236,8 @@ int do_size(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	    int fstype);
 int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	    int fstype);
+int do_gzload(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
+	      int fstype);
 int do_ls(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	  int fstype);
 int file_exists(const char *dev_type, const char *dev_part, const char *file,
@@ -108,6 +108,10 @@
 #define PROCTL_DTW_4		0x00000002
 #define PROCTL_DTW_8		0x00000004
 #define PROCTL_D3CD		0x00000008
+#define PROCTL_DMAS_MASK	0x00000300
+#define PROCTL_DMAS_SDMA	0x00000000
+#define PROCTL_DMAS_ADMA2	0x00000200
+#define PROCTL_BURST_LEN_INCR	0x08000000
 
 #define CMDARG			0x0002e008
 
@@ -31,6 +31,24 @@ int gzip_parse_header(const unsigned char *src, unsigned long len);
  */
 int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp);
 
+/**
+ * gunzip_stream() - Decompress gzipped data while it is read in chunks
+ *
+ * The compressed data is never held completely in memory. Each chunk is
+ * decompressed right after it was read, directly to the final destination.
+ *
+ * @dst: Destination for uncompressed data
+ * @dstlen: Size of destination buffer
+ * @read: Function to read the next @size bytes of compressed data to @buf;
+ *	returns the number of bytes read, 0 at end of data, or -ve on error
+ * @priv: Private data passed to @read
+ * @lenp: Returns length of uncompressed data
+ * @return 0 if OK, -1 on error
+ */
+int gunzip_stream(void *dst, int dstlen,
+		  int (*read)(void *priv, unsigned char *buf, ulong size),
+		  void *priv, unsigned long *lenp);
+
 /**
  * zunzip() - Uncompress blocks compressed with zlib without headers
  *
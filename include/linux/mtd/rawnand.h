@@ -100,6 +100,8 @@ void nand_wait_ready(struct mtd_info *mtd);
 
 /* Extended commands for large page devices */
 #define NAND_CMD_READSTART	0x30
+#define NAND_CMD_READCACHESEQ	0x31
+#define NAND_CMD_READCACHEEND	0x3f
 #define NAND_CMD_RNDOUTSTART	0xE0
 #define NAND_CMD_CACHEDPROG	0x15
 
@@ -225,6 +227,8 @@ enum nand_ecc_algo {
 #define NAND_SW_WRITE_PROTECT	0x08000000
 /* Chip can't use bad block marker because of special type of ECC */
 #define NAND_NO_BADBLOCK	0x04000000
+/* Driver can read pages with ONFI READ CACHE SEQUENTIAL */
+#define NAND_CACHE_READ		0x02000000
 
 /* Options valid for Samsung large page devices */
 #define NAND_SAMSUNG_LP_OPTIONS NAND_CACHEPRG
@@ -290,6 +294,9 @@ enum nand_ecc_algo {
 /* ONFI subfeature parameters length */
 #define ONFI_SUBFEATURE_PARAM_LEN	4
 
+/* ONFI optional commands READ CACHE supported? */
+#define ONFI_OPT_CMD_READ_CACHE		(1 << 1)
+
 /* ONFI optional commands SET/GET FEATURES supported? */
 #define ONFI_OPT_CMD_SET_GET_FEATURES	(1 << 2)
 
@@ -872,6 +879,8 @@ nand_get_sdr_timings(const struct nand_data_interface *conf)
  *			data_buf.
  * @pagebuf_bitflips:	[INTERN] holds the bitflip count for the page which is
  *			currently in data_buf.
+ * @cache_read_next:	[INTERN] holds the pagenumber that is loaded by a
+ *			running READ CACHE SEQUENTIAL, 0 if none is running.
  * @subpagesize:	[INTERN] holds the subpagesize
  * @onfi_version:	[INTERN] holds the chip ONFI version (BCD encoded),
  *			non 0 if ONFI supported.
@@ -948,6 +957,7 @@ struct nand_chip {
 	int pagemask;
 	int pagebuf;
 	int pagebuf_bitflips;
+	int cache_read_next;
 	int subpagesize;
 	uint8_t bits_per_cell;
 	uint16_t ecc_strength_ds;
@@ -1306,6 +1316,11 @@ extern loff_t nand_refresh_final_offset(struct mtd_info *mtd, loff_t offset);
 extern void nand_refresh_free_backup(struct mtd_info *mtd);
 extern int nand_refresh(struct mtd_info *mtd, loff_t refreshoffs);
 extern void nand_refresh_init(struct mtd_info *mtd);
+extern int nand_refresh_queue(struct mtd_info *mtd, loff_t refreshoffs);
+extern void nand_refresh_run_queue(struct mtd_info *mtd);
+extern void nand_refresh_account(struct mtd_info *mtd, u32 block,
+				 unsigned int bitflips);
+extern void nand_refresh_show_stats(struct mtd_info *mtd);
 #endif /* CONFIG_NAND_REFRESH */
 
 /* Standard NAND functions from nand_base.c */
@@ -10,6 +10,7 @@
 #define _MMC_H_
 
 #include <linux/bitops.h>
+#include <linux/errno.h>
 #include <linux/list.h>
 #include <linux/sizes.h>
 #include <linux/compiler.h>
@@ -213,6 +214,8 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 /*
  * EXT_CSD fields
  */
+#define EXT_CSD_FLUSH_CACHE		32	/* W */
+#define EXT_CSD_CACHE_CTRL		33	/* R/W/E_P */
 #define EXT_CSD_ENH_START_ADDR		136	/* R/W */
 #define EXT_CSD_ENH_SIZE_MULT		140	/* R/W */
 #define EXT_CSD_GP_SIZE_MULT		143	/* R/W */
@@ -242,6 +245,7 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 #define EXT_CSD_HC_ERASE_GRP_SIZE	224	/* RO */
 #define EXT_CSD_BOOT_MULT		226	/* RO */
 #define EXT_CSD_GENERIC_CMD6_TIME       248     /* RO */
+#define EXT_CSD_CACHE_SIZE		249	/* RO, 4 bytes */
 #define EXT_CSD_BKOPS_SUPPORT		502	/* RO */
 
 /*
@@ -456,6 +460,36 @@ struct dm_mmc_ops {
 	int (*send_cmd)(struct udevice *dev, struct mmc_cmd *cmd,
 			struct mmc_data *data);
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/**
+	 * start_cmd() - Send a data command without waiting for the data
+	 *
+	 * This is optional. It works like send_cmd(), but returns as soon as
+	 * the card has responded to the command. The data transfer continues
+	 * in the background, use poll_data() to check for its completion. No
+	 * other command may be sent before the transfer is complete.
+	 *
+	 * @dev:	Device to receive the command
+	 * @cmd:	Command to send
+	 * @data:	Data to send/receive
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*start_cmd)(struct udevice *dev, struct mmc_cmd *cmd,
+			 struct mmc_data *data);
+
+	/**
+	 * poll_data() - Check whether the data transfer of start_cmd() is done
+	 *
+	 * @dev:	Device that received the command
+	 * @cmd:	Command that was started
+	 * @data:	Data of the command
+	 * @return 0 if complete, -EINPROGRESS if still running, other -ve on
+	 * error
+	 */
+	int (*poll_data)(struct udevice *dev, struct mmc_cmd *cmd,
+			 struct mmc_data *data);
+#endif
+
 	/**
 	 * set_ios() - Set the I/O speed/width for an MMC device
 	 *
@@ -543,6 +577,10 @@ struct dm_mmc_ops {
 
 int dm_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		    struct mmc_data *data);
+int dm_mmc_start_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+		     struct mmc_data *data);
+int dm_mmc_poll_data(struct udevice *dev, struct mmc_cmd *cmd,
+		     struct mmc_data *data);
 int dm_mmc_set_ios(struct udevice *dev);
 int dm_mmc_get_cd(struct udevice *dev);
 int dm_mmc_get_wp(struct udevice *dev);
@@ -693,6 +731,10 @@ struct mmc {
 	u8 part_config;
 	u8 gen_cmd6_time;	/* units: 10 ms */
 	u8 part_switch_time;	/* units: 10 ms */
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+	uint cache_size;	/* units: KiB, 0 if no cache */
+	char cache_on;		/* 1 if the volatile cache is enabled */
+#endif
 	uint tran_speed;
 	uint legacy_speed; /* speed for the legacy mode provided by the card */
 	uint read_bl_len;
@@ -742,6 +784,12 @@ struct mmc {
 				  */
 	u32 quirks;
 	u8 hs400_tuning;
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct blk_req *async_req;	/* Request with active transfer */
+	struct mmc_cmd async_cmd;	/* Command of this transfer */
+	struct mmc_data async_data;	/* Data of this transfer */
+	lbaint_t async_cur;		/* Blocks of this transfer */
+#endif
 };
 
 #if CONFIG_IS_ENABLED(DM_MMC)
@@ -1023,6 +1071,51 @@ int mmc_send_ext_csd(struct mmc *mmc, u8 *ext_csd);
  */
 int mmc_boot_wp(struct mmc *mmc);
 
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+/**
+ * mmc_cache_ctrl() - switch the volatile cache of an eMMC on or off
+ *
+ * Switching the cache off flushes its content to the medium first.
+ *
+ * @mmc:	MMC device
+ * @enable:	true to enable the cache, false to disable it
+ * Return:	0 for success, -EMEDIUMTYPE if the device has no cache
+ */
+int mmc_cache_ctrl(struct mmc *mmc, bool enable);
+
+/**
+ * mmc_flush_cache() - write the volatile cache of an eMMC to the medium
+ *
+ * Does nothing if the cache is not enabled.
+ *
+ * @mmc:	MMC device
+ * Return:	0 for success
+ */
+int mmc_flush_cache(struct mmc *mmc);
+
+/**
+ * mmc_flush_caches() - write the volatile caches of all eMMCs to the medium
+ *
+ * This is meant for points where the medium is handed over, e.g. before a
+ * reset or when a USB host is done with it. Errors are only reported.
+ */
+void mmc_flush_caches(void);
+#else
+static inline int mmc_cache_ctrl(struct mmc *mmc, bool enable)
+{
+	return -EMEDIUMTYPE;
+}
+
+static inline int mmc_flush_cache(struct mmc *mmc)
+{
+	return 0;
+}
+
+static inline void mmc_flush_caches(void)
+{
+}
+#endif
+
 static inline enum dma_data_direction mmc_get_dma_dir(struct mmc_data *data)
 {
 	return data->flags & MMC_DATA_WRITE ? DMA_TO_DEVICE : DMA_FROM_DEVICE;
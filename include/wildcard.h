@@ -21,6 +21,7 @@
    must clear them after they have taken effect once. */
 #define WC_FLAGS_REWIND 0x01		/* (Re)start at beginning of dir */
 #define WC_FLAGS_RELOAD	0x02		/* Resume dir after handling subdir */
+#define WC_FLAGS_UNIQUE	0x04		/* Dir pattern had only one match */
 
 /* Filesystem doing the call; used as index into the wc_filesystem_ops array */
 enum wc_filesystem {
@@ -76,6 +77,9 @@ struct wc_fsops {
 			  loff_t *actwrite);
 	int (*get_symlink)(struct wc_dirinfo *wdi, struct wc_fileinfo *wfi,
 			   char *symlink);
+	/* Optional: direct lookup of a name without wildcards */
+	int (*find_file)(struct wc_dirinfo *wdi, struct wc_fileinfo *wfi,
+			 const char *name);
 };
 
 
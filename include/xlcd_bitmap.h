@@ -45,7 +45,7 @@ enum bitmap_types {
 	BT_BMP,
 #endif
 #ifdef CONFIG_XLCD_JPG
-	BT_JPG,				  /* ### Not supported yet ### */
+	BT_JPG,
 #endif
 };
 
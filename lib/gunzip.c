@@ -26,6 +26,7 @@
 #define COMMENT			0x10
 #define RESERVED		0xe0
 #define DEFLATED		8
+#define GZIP_STREAM_CHUNK	(512 * 1024)	/* Bytes read at once */
 
 void *gzalloc(void *x, unsigned items, unsigned size)
 {
@@ -82,6 +83,83 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 	return zunzip(dst, dstlen, src, lenp, 1, offset);
 }
 
+int gunzip_stream(void *dst, int dstlen,
+		  int (*read)(void *priv, unsigned char *buf, ulong size),
+		  void *priv, unsigned long *lenp)
+{
+	unsigned char *buf;
+	z_stream s;
+	int offset = -1;
+	int err = -1;
+	int len;
+	int r;
+
+	buf = malloc_cache_aligned(GZIP_STREAM_CHUNK);
+	if (!buf) {
+		puts("Error: gunzip out of memory\n");
+		return -1;
+	}
+
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+
+	r = inflateInit2(&s, -MAX_WBITS);
+	if (r != Z_OK) {
+		printf("Error: inflateInit2() returned %d\n", r);
+		free(buf);
+		return -1;
+	}
+	s.next_out = dst;
+	s.avail_out = dstlen;
+
+	/*
+	 * Decompress each chunk directly after it was read. As the output
+	 * goes to one large buffer, inflate() always consumes the whole
+	 * chunk, so the buffer can be reused for the next chunk.
+	 */
+	do {
+		len = read(priv, buf, GZIP_STREAM_CHUNK);
+		if (len < 0)
+			goto out;
+		if (!len) {
+			puts("Error: gunzip out of data\n");
+			goto out;
+		}
+		s.next_in = buf;
+		s.avail_in = len;
+		if (offset < 0) {
+			/* First chunk, skip gzip header */
+			offset = gzip_parse_header(buf, len);
+			if (offset < 0)
+				goto out;
+			s.next_in += offset;
+			s.avail_in -= offset;
+		}
+		r = inflate(&s, Z_NO_FLUSH);
+		if ((r != Z_OK) && (r != Z_STREAM_END)) {
+			printf("Error: inflate() returned %d\n", r);
+			goto out;
+		}
+		if ((r == Z_OK) && s.avail_in) {
+			puts("Error: gunzip destination buffer too small\n");
+			goto out;
+		}
+		if (ctrlc()) {
+			puts("abort\n");
+			goto out;
+		}
+		WATCHDOG_RESET();
+	} while (r != Z_STREAM_END);
+	err = 0;
+
+out:
+	*lenp = s.next_out - (unsigned char *)dst;
+	inflateEnd(&s);
+	free(buf);
+
+	return err;
+}
+
 #ifdef CONFIG_CMD_UNZIP
 __weak
 void gzwrite_progress_init(u64 expectedsize)
@@ -116,6 +194,22 @@ void gzwrite_progress_finish(int returnval,
 	}
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/* Wait for an asynchronous write of gzwrite(), return false on error */
+static bool gzwrite_wait(struct blk_req *req)
+{
+	long result = blk_req_wait(req);
+
+	if (result == req->blkcnt)
+		return true;
+
+	printf("Error: writing block " LBAF " failed (%ld)\n",
+	       req->start, result);
+
+	return false;
+}
+#endif
+
 int gzwrite(unsigned char *src, int len,
 	    struct blk_desc *dev,
 	    unsigned long szwritebuf,
@@ -132,6 +226,11 @@ int gzwrite(unsigned char *src, int len,
 	u32 expected_crc;
 	u32 payload_size;
 	int iteration = 0;
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	unsigned char *nextbuf;
+	struct blk_req req;
+	bool pending = false;
+#endif
 
 	if (!szwritebuf ||
 	    (szwritebuf % dev->blksz) ||
@@ -206,6 +305,10 @@ int gzwrite(unsigned char *src, int len,
 	s.next_in = src + i;
 	s.avail_in = payload_size+8;
 	writebuf = (unsigned char *)malloc_cache_aligned(szwritebuf);
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/* Decompress into the second buffer while the first one is written */
+	nextbuf = (unsigned char *)malloc_cache_aligned(szwritebuf);
+#endif
 
 	/* decompress until deflate stream ends or end of file */
 	do {
@@ -244,9 +347,30 @@ int gzwrite(unsigned char *src, int len,
 			gzwrite_progress(iteration++,
 					 totalfilled,
 					 szexpected);
-			blocks_written = blk_dwrite(dev, outblock,
-						    writeblocks, writebuf);
-			outblock += blocks_written;
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+			if (pending && !gzwrite_wait(&req)) {
+				pending = false;
+				r = -1;
+				goto out;
+			}
+			pending = false;
+			if (nextbuf && !blk_dwrite_async(dev, outblock,
+							 writeblocks, writebuf,
+							 &req)) {
+				unsigned char *tmp = writebuf;
+
+				pending = true;
+				outblock += writeblocks;
+				writebuf = nextbuf;
+				nextbuf = tmp;
+			} else
+#endif
+			{
+				blocks_written = blk_dwrite(dev, outblock,
+							    writeblocks,
+							    writebuf);
+				outblock += blocks_written;
+			}
 			if (ctrlc()) {
 				puts("abort\n");
 				goto out;
@@ -256,6 +380,16 @@ int gzwrite(unsigned char *src, int len,
 		/* done when inflate() says it's done */
 	} while (r != Z_STREAM_END);
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	if (pending) {
+		pending = false;
+		if (!gzwrite_wait(&req)) {
+			r = -1;
+			goto out;
+		}
+	}
+#endif
+
 	if ((szexpected != totalfilled) ||
 	    (crc != expected_crc))
 		r = -1;
@@ -263,6 +397,11 @@ int gzwrite(unsigned char *src, int len,
 		r = 0;
 
 out:
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	if (pending)
+		blk_req_wait(&req);
+	free(nextbuf);
+#endif
 	gzwrite_progress_finish(r, totalfilled, szexpected,
 				expected_crc, crc);
 	free(writebuf);
@@ -64,10 +64,12 @@
 # #define FSH_FLAGS_DESCR 0x8000	/* Description descr is present */
 # #define FSH_FLAGS_CRC32 0x4000	/* CRC32 of image in type[12..15] */
 # #define FSH_FLAGS_SECURE 0x2000	/* CRC32 of header in type[12..15] */
+# #define FSH_FLAGS_SHA256 0x1000	/* SHA-256 of image in last 32 bytes */
 
 FSH_FLAGS_DESCR=0x8000
 FSH_FLAGS_CRC32=0x4000
 FSH_FLAGS_SECURE=0x2000
+FSH_FLAGS_SHA256=0x1000
 
 usage()
 {
@@ -97,6 +99,8 @@ Options:
                         to the given value(s) <val>.
   -q | --quiet          Do not output progress
   -s | --secure         Set flags bit 13, store header CRC32 in type[12..15]
+  -S | --sha256         Set flags bit 12, append SHA-256 of the (padded) image
+                        data as last 32 bytes of the image
   -t | --type <string>  Set image type to <string> (at most 16 characters)
   -v | --version <vers> Create a header of version <vers> (default $version)
                         <vers> can be one of: $versions
@@ -109,7 +113,7 @@ This includes the file abc.txt as image and assigns the values 0x01234567 to
 p32[5], 0x89abcdef to p32[6], 0x12 to p8[2], 0x34 to p8[3] and 0x56 to p8[4].
 Be careful to avoid overlapping of description and parameters. If any CRC32
 option is given, the type must not exceed 11 characters and the crc32 command
-has to be available on the system.
+has to be available on the system. Option -S needs the sha256sum command.
 
 __USAGE_EOF
 
@@ -285,6 +289,7 @@ outfile=
 pad=1
 quiet=0
 secure=0
+do_sha256=0
 
 # We need xxd, check if it is available
 command -v xxd > /dev/null
@@ -338,6 +343,9 @@ while [ $# -gt 0 ]; do
 	-s|--secure)
 	    secure=1
 	    ;;
+	-S|--sha256)
+	    do_sha256=1
+	    ;;
 	-t|--type)
 	    type=$2
 	    shift
@@ -400,6 +408,21 @@ if [ $padsize -gt 0 ]; then
     size=$(($size + $padsize))
 fi
 
+# Append SHA-256 of the padded image data and set flag 12 if requested. This
+# is part of the image, so a CRC32 of the image also covers the digest.
+if [ $do_sha256 -eq 1 ]; then
+    command -v sha256sum > /dev/null
+    if [ $? -ne 0 ]; then
+	echo "Command 'sha256sum' missing, please install appropriate package" >&2
+	rm "$temp"
+	exit 1
+    fi
+
+    sha256sum "$temp" | head -c 64 | xxd -r -p >> "$temp"
+    size=$(($size + 32))
+    flags=$(($flags | $FSH_FLAGS_SHA256))
+fi
+
 # Add description and set flag 15 if requested (<=32 bytes, zero-terminated).
 # This is done last so that the description is always valid.
 if [ -n "$descr" ]; then
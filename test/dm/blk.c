@@ -162,3 +162,215 @@ static int dm_test_blk_get_from_parent(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_get_from_parent, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLOCK_CACHE)
+/* Fill some blocks of a block device with a known pattern */
+static int blk_test_fill(struct unit_test_state *uts, struct blk_desc *desc,
+			 lbaint_t start, lbaint_t blkcnt, u8 *buf)
+{
+	ulong i;
+
+	for (i = 0; i < blkcnt * desc->blksz; i++)
+		buf[i] = (start * desc->blksz + i) / 4;
+	ut_asserteq(blkcnt, blk_dwrite(desc, start, blkcnt, buf));
+
+	return 0;
+}
+
+/* Read blocks and check that they hold the pattern from blk_test_fill() */
+static int blk_test_check(struct unit_test_state *uts, struct blk_desc *desc,
+			  lbaint_t start, lbaint_t blkcnt, u8 *buf)
+{
+	ulong i;
+
+	memset(buf, 0xff, blkcnt * desc->blksz);
+	ut_asserteq(blkcnt, blk_dread(desc, start, blkcnt, buf));
+	for (i = 0; i < blkcnt * desc->blksz; i++)
+		ut_asserteq((u8)((start * desc->blksz + i) / 4), buf[i]);
+
+	return 0;
+}
+
+/* Get the cache statistics of one device */
+static int blk_test_dev_stats(struct unit_test_state *uts,
+			      struct blk_desc *desc,
+			      struct block_cache_dev_stats *stats)
+{
+	int i;
+
+	for (i = 0; !blkcache_dev_stats(i, stats); i++) {
+		if ((stats->iftype == desc->if_type) &&
+		    (stats->devnum == desc->devnum))
+			return 0;
+	}
+	ut_assertf(0, "no cache statistics for device\n");
+
+	return 0;
+}
+
+/* Test that the block cache evicts the oldest extents to stay in budget */
+static int dm_test_blk_cache_evict(struct unit_test_state *uts)
+{
+	struct block_cache_stats stats;
+	struct blk_desc *desc;
+	struct udevice *dev;
+	u8 buf[2 * 512];
+	int i;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &desc));
+	for (i = 1; i <= 5; i++)
+		ut_assertok(blk_test_fill(uts, desc, i * 10, 2, buf));
+
+	/* Room for four extents of two blocks */
+	blkcache_configure(32, 4 * 2 * desc->blksz);
+
+	for (i = 1; i <= 5; i++)
+		ut_assertok(blk_test_check(uts, desc, i * 10, 2, buf));
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.hits);
+	ut_asserteq(5, stats.misses);
+	ut_asserteq(1, stats.evictions);
+	ut_asserteq(4, stats.entries);
+	ut_asserteq(4 * 2 * desc->blksz, stats.bytes);
+
+	/* The first extent is gone, using the second one makes it recent */
+	ut_assertok(blk_test_check(uts, desc, 50, 2, buf));
+	ut_assertok(blk_test_check(uts, desc, 20, 2, buf));
+	ut_assertok(blk_test_check(uts, desc, 10, 2, buf));
+	ut_assertok(blk_test_check(uts, desc, 20, 2, buf));
+	ut_assertok(blk_test_check(uts, desc, 30, 2, buf));
+	blkcache_stats(&stats);
+	ut_asserteq(3, stats.hits);
+	ut_asserteq(2, stats.misses);
+	ut_asserteq(2, stats.evictions);
+	ut_asserteq(4 * 2 * desc->blksz, stats.bytes);
+
+	/* Back to the defaults */
+	blkcache_configure(32, 512 * 1024);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache_evict, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test that sequential reads are served from read-ahead data */
+static int dm_test_blk_cache_readahead(struct unit_test_state *uts)
+{
+	struct block_cache_dev_stats dstats;
+	struct block_cache_stats stats;
+	struct blk_desc *desc;
+	struct udevice *dev;
+	u8 buf[8 * 512];
+	lbaint_t end;
+	int i;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &desc));
+	ut_assertok(blk_test_fill(uts, desc, 100, 8, buf));
+	ut_assertok(blk_test_fill(uts, desc, 108, 4, buf));
+	blkcache_configure(32, 64 * desc->blksz);
+
+	/* Misses at 100, 102 and 106; 102 reads 2 and 106 reads 4 ahead */
+	for (i = 100; i < 112; i += 2)
+		ut_assertok(blk_test_check(uts, desc, i, 2, buf));
+	ut_assertok(blk_test_dev_stats(uts, desc, &dstats));
+	ut_asserteq(3, dstats.hits);
+	ut_asserteq(3, dstats.misses);
+	ut_asserteq(6, dstats.readahead);
+	blkcache_stats(&stats);
+
+	/* Read-ahead stops at the end of the device: 2 + 2 instead of 2 + 4 */
+	end = desc->lba;
+	for (i = 10; i > 0; i -= 2)
+		ut_assertok(blk_test_fill(uts, desc, end - i, 2, buf));
+	for (i = 10; i > 0; i -= 2)
+		ut_assertok(blk_test_check(uts, desc, end - i, 2, buf));
+	ut_assertok(blk_test_dev_stats(uts, desc, &dstats));
+	ut_asserteq(2, dstats.hits);
+	ut_asserteq(3, dstats.misses);
+	ut_asserteq(4, dstats.readahead);
+	blkcache_stats(&stats);
+
+	blkcache_configure(32, 512 * 1024);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache_readahead, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/* Test that asynchronous requests complete in order with the right data */
+static int dm_test_blk_async(struct unit_test_state *uts)
+{
+	struct blk_req req[2], wreq;
+	struct blk_desc *desc;
+	struct udevice *dev;
+	u8 buf[2][4 * 512];
+	u8 wbuf[2 * 512];
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &desc));
+	ut_assertok(blk_test_fill(uts, desc, 200, 8, buf[0]));
+
+	/* The sandbox transfer needs two polls, the second read must wait */
+	ut_assertok(blk_dread_async(desc, 200, 4, buf[0], &req[0]));
+	ut_assertok(blk_dread_async(desc, 204, 4, buf[1], &req[1]));
+	ut_asserteq(-EINPROGRESS, req[0].result);
+	ut_asserteq(-EINPROGRESS, req[1].result);
+	ut_asserteq(4, blk_req_wait(&req[0]));
+	ut_asserteq(-EINPROGRESS, req[1].result);
+	ut_asserteq(4, blk_req_wait(&req[1]));
+	ut_asserteq(4, blk_req_poll(&req[1]));
+	ut_asserteq((u8)(200 * 512 / 4), buf[0][0]);
+	ut_asserteq((u8)((204 * 512 + 4 * 512 - 1) / 4), buf[1][4 * 512 - 1]);
+
+	/* Write asynchronously, then read back synchronously */
+	memset(wbuf, 0x5a, sizeof(wbuf));
+	ut_assertok(blk_dwrite_async(desc, 210, 2, wbuf, &wreq));
+	ut_asserteq(2, blk_req_wait(&wreq));
+	memset(wbuf, 0, sizeof(wbuf));
+	ut_asserteq(2, blk_dread(desc, 210, 2, wbuf));
+	ut_asserteq(0x5a, wbuf[0]);
+	ut_asserteq(0x5a, wbuf[sizeof(wbuf) - 1]);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_async, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test that a read overlapping with a write does not leave stale cache data */
+static int dm_test_blk_async_cache(struct unit_test_state *uts)
+{
+	struct block_cache_dev_stats dstats;
+	struct blk_req rreq, wreq;
+	struct blk_desc *desc;
+	struct udevice *dev;
+	u8 rbuf[2 * 512];
+	u8 wbuf[2 * 512];
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &desc));
+	ut_assertok(blk_test_fill(uts, desc, 220, 2, rbuf));
+	blkcache_configure(32, 64 * desc->blksz);
+
+	/* The read is done first and gets the old data */
+	memset(wbuf, 0xa5, sizeof(wbuf));
+	ut_assertok(blk_dread_async(desc, 220, 2, rbuf, &rreq));
+	ut_assertok(blk_dwrite_async(desc, 220, 2, wbuf, &wreq));
+	ut_asserteq(2, blk_req_wait(&wreq));
+	ut_asserteq(2, blk_req_wait(&rreq));
+	ut_asserteq((u8)(220 * 512 / 4), rbuf[0]);
+
+	/* But it must not be served from the cache afterwards */
+	memset(rbuf, 0, sizeof(rbuf));
+	ut_asserteq(2, blk_dread(desc, 220, 2, rbuf));
+	ut_asserteq(0xa5, rbuf[0]);
+	ut_asserteq(0xa5, rbuf[sizeof(rbuf) - 1]);
+	ut_assertok(blk_test_dev_stats(uts, desc, &dstats));
+	ut_asserteq(0, dstats.hits);
+
+	blkcache_configure(32, 512 * 1024);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_async_cache, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+#endif
+#endif